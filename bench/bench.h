@@ -0,0 +1,57 @@
+#pragma once
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "utils/data_generator.h"
+#include <functional>
+
+namespace infini
+{
+
+    struct BenchResult
+    {
+        string name;
+        size_t iterations;
+        // seconds per iteration, averaged and the fastest one
+        double mean, min;
+        // work of one iteration
+        double flops, bytes;
+    };
+
+    // Runs one benchmark for at least `minTime` seconds.
+    using BenchFn = std::function<BenchResult(double minTime)>;
+
+    class BenchRegistry
+    {
+        vector<pair<string, BenchFn>> benches;
+
+    public:
+        static BenchRegistry &getInstance()
+        {
+            static BenchRegistry instance;
+            return instance;
+        }
+        bool add(const string &name, BenchFn fn)
+        {
+            benches.emplace_back(name, std::move(fn));
+            return true;
+        }
+        const vector<pair<string, BenchFn>> &getBenches() const
+        {
+            return benches;
+        }
+    };
+
+    /**
+     * @brief Calls `fn` once to warm up, then repeatedly until `minTime`
+     * seconds have passed, and at least three times.
+     */
+    BenchResult timeIt(const string &name, double minTime, double flops,
+                       double bytes, const std::function<void()> &fn);
+
+    /**
+     * @brief Times runtime->run(g) on an allocated graph. The work per run
+     * is the sum of the Profiler estimates over the operators.
+     */
+    BenchResult timeGraph(const string &name, double minTime, const Graph &g);
+
+} // namespace infini
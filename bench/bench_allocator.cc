@@ -0,0 +1,120 @@
+#include "bench.h"
+#include "core/allocator.h"
+#include "operators/element_wise.h"
+#include "operators/unary.h"
+#include <chrono>
+#include <cstring>
+#include <random>
+
+// Memory planning: the raw Allocator, and dataMalloc() over whole graphs.
+// Work is reported as the number of alloc/free calls, or of operators
+// planned, so the GFLOP/s column reads as billions of those per second.
+// The arena benchmarks report the bytes of the arena instead.
+namespace infini
+{
+
+    static BenchResult benchAllocFree(double minTime)
+    {
+        const int n = 4096;
+        // random sizes, and every other step frees a random live block, which
+        // keeps about half the blocks live and exercises coalescing
+        std::mt19937 rng(0);
+        vector<size_t> sizes(n);
+        vector<uint32_t> picks(n);
+        for (int i = 0; i < n; ++i)
+        {
+            sizes[i] = 64 + rng() % (1 << 16);
+            picks[i] = rng();
+        }
+
+        auto runtime = NativeCpuRuntimeObj::getInstance();
+        return timeIt("allocator/alloc_free/4096", minTime, 1.5 * n, 0, [&]
+                      {
+            Allocator allocator(runtime);
+            vector<pair<size_t, size_t>> live;
+            live.reserve(n);
+            for (int i = 0; i < n; ++i)
+            {
+                live.emplace_back(allocator.alloc(sizes[i]), sizes[i]);
+                if (i % 2)
+                {
+                    size_t victim = picks[i] % live.size();
+                    allocator.free(live[victim].first, live[victim].second);
+                    live[victim] = live.back();
+                    live.pop_back();
+                }
+            } });
+    }
+
+    // A ladder of `width` parallel Relu chains of `depth` ops, joined by Adds.
+    static Graph buildLadder(int width, int depth)
+    {
+        Graph g = make_ref<GraphObj>(NativeCpuRuntimeObj::getInstance());
+        TensorVec chains;
+        for (int w = 0; w < width; ++w)
+            chains.push_back(g->addTensor({64, 64}));
+        for (int d = 0; d < depth; ++d)
+            for (auto &t : chains)
+                t = g->addOp<ReluObj>(t, nullptr)->getOutput();
+        Tensor sum = chains[0];
+        for (int w = 1; w < width; ++w)
+            sum = g->addOp<AddObj>(sum, chains[w], nullptr)->getOutput();
+        return g;
+    }
+
+    // dataMalloc() can run only once per graph, so every iteration plans a
+    // fresh copy, built outside the timed region. The time covers planning
+    // and obtaining the arena; neither writes to stdout.
+    static BenchResult benchDataMalloc(double minTime)
+    {
+        using Clock = std::chrono::steady_clock;
+        using Seconds = std::chrono::duration<double>;
+        const int width = 16, depth = 64;
+        size_t iterations = 0;
+        double total = 0, fastest = 1e30;
+        while (total < minTime || iterations < 3)
+        {
+            Graph g = buildLadder(width, depth);
+            auto begin = Clock::now();
+            g->dataMalloc();
+            double t = Seconds(Clock::now() - begin).count();
+            total += t;
+            fastest = std::min(fastest, t);
+            ++iterations;
+        }
+        return {"allocator/data_malloc/ladder16x64", iterations,
+                total / iterations, fastest,
+                double(width * depth + width - 1), 0};
+    }
+
+    // Obtains an arena and fills it once, as the first run of a graph does,
+    // so the page faults are part of the time.
+    static BenchFn benchArena(string name, size_t bytes, CpuAllocPolicy policy)
+    {
+        return [=](double minTime)
+        {
+            auto runtime = make_ref<NativeCpuRuntimeObj>();
+            runtime->setAllocPolicy(policy);
+            return timeIt(name, minTime, 0, bytes, [&]
+                          {
+                void *ptr = runtime->alloc(bytes);
+                std::memset(ptr, 1, bytes);
+                runtime->dealloc(ptr); });
+        };
+    }
+
+    static const bool registered = []
+    {
+        auto &registry = BenchRegistry::getInstance();
+        registry.add("allocator/alloc_free/4096", benchAllocFree);
+        registry.add("allocator/data_malloc/ladder16x64", benchDataMalloc);
+        const size_t arena = size_t(256) << 20;
+        for (auto [name, policy] :
+             {pair{"allocator/arena/256MiB", CpuAllocPolicy{}},
+              pair{"allocator/arena/256MiB/huge_prefault",
+                   CpuAllocPolicy{64, true, true}}})
+            registry.add(name, benchArena(name, arena, policy));
+        return true;
+    }();
+
+} // namespace infini
@@ -0,0 +1,83 @@
+#include "bench.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+// End-to-end graphs, timed with and without inter-operator parallelism and
+// graph optimizations.
+namespace infini
+{
+
+    static Tensor linear(const Graph &g, Tensor x, int in, int out)
+    {
+        auto y = g->addOp<MatmulObj>(x, g->addTensor({in, out}), nullptr)
+                     ->getOutput();
+        return g->addOp<AddObj>(y, g->addTensor({1, out}), nullptr)
+            ->getOutput();
+    }
+
+    // batch x 1024 -> 4096 -> 1024 -> 256, Relu between the layers
+    static void buildMlp(const Graph &g)
+    {
+        const int batch = 64;
+        Tensor x = g->addTensor({batch, 1024});
+        x = g->addOp<ReluObj>(linear(g, x, 1024, 4096), nullptr)->getOutput();
+        x = g->addOp<ReluObj>(linear(g, x, 4096, 1024), nullptr)->getOutput();
+        linear(g, x, 1024, 256);
+    }
+
+    // One single-head attention block with a residual connection. The tree
+    // has no Softmax, Relu stands in for it.
+    static void buildAttention(const Graph &g)
+    {
+        const int batch = 8, seq = 256, dim = 512;
+        Tensor x = g->addTensor({batch, seq, dim});
+        auto project = [&](Tensor in)
+        {
+            return g->addOp<MatmulObj>(in, g->addTensor({1, dim, dim}), nullptr)
+                ->getOutput();
+        };
+        Tensor q = project(x), k = project(x), v = project(x);
+        Tensor kt =
+            g->addOp<TransposeObj>(k, nullptr, Shape{0, 2, 1})->getOutput();
+        Tensor scores = g->addOp<MatmulObj>(q, kt, nullptr)->getOutput();
+        scores = g->addOp<MulObj>(scores, g->addTensor(Shape{1}), nullptr)
+                     ->getOutput();
+        Tensor probs = g->addOp<ReluObj>(scores, nullptr)->getOutput();
+        Tensor ctx = g->addOp<MatmulObj>(probs, v, nullptr)->getOutput();
+        g->addOp<AddObj>(project(ctx), x, nullptr);
+    }
+
+    // Sequential, with inter-operator parallelism, and after optimize().
+    static void addModelBench(const string &name,
+                              void (*build)(const Graph &))
+    {
+        for (string variant : {"", "/interop", "/optimized"})
+        {
+            string fullName = "graph/" + name + variant;
+            BenchRegistry::getInstance().add(fullName, [=](double minTime)
+                                             {
+                auto runtime = NativeCpuRuntimeObj::getInstance();
+                Graph g = make_ref<GraphObj>(runtime);
+                build(g);
+                if (variant == "/optimized")
+                    g->optimize();
+                g->dataMalloc();
+                for (auto &input : g->getInputs())
+                    input->setData(OneGenerator());
+                runtime->setInterOpThreads(variant == "/interop" ? 0 : 1);
+                auto result = timeGraph(fullName, minTime, g);
+                runtime->setInterOpThreads(1);
+                return result; });
+        }
+    }
+
+    static const bool registered = []
+    {
+        addModelBench("mlp", buildMlp);
+        addModelBench("attention", buildAttention);
+        return true;
+    }();
+
+} // namespace infini
@@ -0,0 +1,166 @@
+#include "bench.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+#include <cstring>
+
+// Single-operator graphs, one benchmark per shape or variant.
+namespace infini
+{
+
+    // CPU blocks are not zeroed, so every input is filled: float types
+    // with ones, the others with zeros, which no generator covers for all
+    // integer widths.
+    static void fillInputs(const Graph &g)
+    {
+        for (auto &tensor : g->getInputs())
+        {
+            auto dtype = tensor->getDType();
+            if (dtype == DataType::Float32 || dtype == DataType::Float16 ||
+                dtype == DataType::BFloat16)
+                tensor->setData(OneGenerator());
+            else
+                std::memset(tensor->getRawDataPtr<void *>(), 0,
+                            tensor->getBytes());
+        }
+    }
+
+    // Builds a graph with `build`, allocates it and times it.
+    static void addGraphBench(const string &name,
+                              std::function<void(const Graph &)> build)
+    {
+        BenchRegistry::getInstance().add(name, [=](double minTime)
+                                         {
+            Graph g = make_ref<GraphObj>(NativeCpuRuntimeObj::getInstance());
+            build(g);
+            g->dataMalloc();
+            fillInputs(g);
+            return timeGraph(name, minTime, g); });
+    }
+
+    static string shapeName(const Shape &shape)
+    {
+        string out;
+        for (size_t i = 0; i < shape.size(); ++i)
+            out += (i ? "x" : "") + std::to_string(shape[i]);
+        return out;
+    }
+
+    static void registerElementWise()
+    {
+        // one case per broadcast pattern the kernel specializes
+        const vector<pair<string, pair<Shape, Shape>>> cases{
+            {"same", {{1024, 1024}, {1024, 1024}}},
+            {"scalar", {{1024, 1024}, {1}}},
+            {"row", {{1024, 1024}, {1, 1024}}},
+            {"column", {{1024, 1024}, {1024, 1}}},
+            {"outer", {{1024, 1}, {1, 1024}}},
+            {"general", {{16, 1, 64, 64}, {1, 16, 1, 64}}},
+        };
+        for (auto &[pattern, shapes] : cases)
+            for (auto dtype : {DataType::Float32, DataType::Float16})
+            {
+                auto [a, b] = shapes;
+                addGraphBench("elementwise/add/" + pattern + "/" +
+                                  dtype.toString(),
+                              [=](const Graph &g)
+                              { g->addOp<AddObj>(g->addTensor(a, dtype),
+                                                 g->addTensor(b, dtype),
+                                                 nullptr); });
+            }
+        addGraphBench("elementwise/div/same/Float32", [](const Graph &g)
+                      { g->addOp<DivObj>(g->addTensor({1024, 1024}),
+                                         g->addTensor({1024, 1024}),
+                                         nullptr); });
+        addGraphBench("unary/relu/Float32", [](const Graph &g)
+                      { g->addOp<ReluObj>(g->addTensor(Shape{1 << 20}),
+                                          nullptr); });
+    }
+
+    static void registerTranspose()
+    {
+        const vector<pair<Shape, Shape>> cases{
+            {{1024, 1024}, {1, 0}},
+            {{64, 256, 256}, {0, 2, 1}},
+            {{8, 64, 16, 64}, {0, 2, 1, 3}},
+            {{8, 64, 16, 64}, {0, 2, 3, 1}},
+            {{32, 32, 32, 32}, {3, 2, 1, 0}},
+        };
+        for (auto &[shape, perm] : cases)
+            addGraphBench("transpose/" + shapeName(shape) + "/perm" +
+                              shapeName(perm),
+                          [=](const Graph &g)
+                          { g->addOp<TransposeObj>(g->addTensor(shape), nullptr,
+                                                   perm); });
+    }
+
+    static void registerConcat()
+    {
+        for (int axis = 0; axis < 3; ++axis)
+            addGraphBench("concat/4x" + shapeName({64, 64, 256}) + "/axis" +
+                              std::to_string(axis),
+                          [=](const Graph &g)
+                          {
+                              TensorVec inputs;
+                              for (int i = 0; i < 4; ++i)
+                                  inputs.push_back(g->addTensor({64, 64, 256}));
+                              g->addOp<ConcatObj>(inputs, nullptr, axis);
+                          });
+    }
+
+    static void registerMatmul()
+    {
+        // M, N, K, batch
+        const vector<vector<int>> cases{
+            {512, 512, 512, 1},
+            {1024, 1024, 1024, 1},
+            {1, 4096, 1024, 1},
+            {128, 64, 64, 32},
+            {4096, 64, 64, 1},
+        };
+        for (auto &c : cases)
+            for (auto dtype : {DataType::Float32, DataType::BFloat16})
+            {
+                int m = c[0], n = c[1], k = c[2], batch = c[3];
+                addGraphBench("matmul/" + shapeName({batch, m, n, k}) + "/" +
+                                  dtype.toString(),
+                              [=](const Graph &g)
+                              { g->addOp<MatmulObj>(
+                                    g->addTensor({batch, m, k}, dtype),
+                                    g->addTensor({batch, k, n}, dtype),
+                                    nullptr); });
+            }
+    }
+
+    static void registerCast()
+    {
+        const vector<tuple<string, DataType, CastType>> cases{
+            {"Float2Float16", DataType::Float32, CastType::Float2Float16},
+            {"Float162Float", DataType::Float16, CastType::Float162Float},
+            {"Float2BFloat16", DataType::Float32, CastType::Float2BFloat16},
+            {"Float2Int32", DataType::Float32, CastType::Float2Int32},
+            {"Int322Float", DataType::Int32, CastType::Int322Float},
+            {"Int322Int8", DataType::Int32, CastType::Int322Int8},
+            {"Int642Int32", DataType::Int64, CastType::Int642Int32},
+        };
+        for (auto &[name, dtype, type] : cases)
+            addGraphBench("cast/" + name, [=, type = type, dtype = dtype](
+                                              const Graph &g)
+                          { g->addOp<CastObj>(
+                                g->addTensor(Shape{1 << 22}, dtype), nullptr,
+                                type); });
+    }
+
+    static const bool registered = []
+    {
+        registerElementWise();
+        registerTranspose();
+        registerConcat();
+        registerMatmul();
+        registerCast();
+        return true;
+    }();
+
+} // namespace infini
@@ -0,0 +1,124 @@
+#include "bench.h"
+#include "core/profiler.h"
+#include "core/thread_pool.h"
+#include "utils/cpu_features.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+namespace infini
+{
+
+    BenchResult timeIt(const string &name, double minTime, double flops,
+                       double bytes, const std::function<void()> &fn)
+    {
+        using Clock = std::chrono::steady_clock;
+        using Seconds = std::chrono::duration<double>;
+        fn();
+        size_t iterations = 0;
+        double total = 0, fastest = 1e30;
+        while (total < minTime || iterations < 3)
+        {
+            auto begin = Clock::now();
+            fn();
+            double t = Seconds(Clock::now() - begin).count();
+            total += t;
+            fastest = std::min(fastest, t);
+            ++iterations;
+        }
+        return {name, iterations, total / iterations, fastest, flops, bytes};
+    }
+
+    BenchResult timeGraph(const string &name, double minTime, const Graph &g)
+    {
+        double flops = 0, bytes = 0;
+        for (auto &op : g->getOperators())
+        {
+            flops += Profiler::estimateFlops(op);
+            bytes += Profiler::estimateBytes(op);
+        }
+        auto runtime = g->getRuntime();
+        return timeIt(name, minTime, flops, bytes, [&]
+                      { runtime->run(g); });
+    }
+
+} // namespace infini
+
+using namespace infini;
+
+static void usage(const char *argv0)
+{
+    std::cerr << "usage: " << argv0
+              << " [--filter SUBSTRING] [--min-time SECONDS] [--out FILE]"
+              << " [--list]\n";
+}
+
+int main(int argc, char **argv)
+{
+    string filter, out = "bench.json";
+    double minTime = 0.2;
+    bool list = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!std::strcmp(argv[i], "--filter") && i + 1 < argc)
+            filter = argv[++i];
+        else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc)
+            minTime = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--out") && i + 1 < argc)
+            out = argv[++i];
+        else if (!std::strcmp(argv[i], "--list"))
+            list = true;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    vector<BenchResult> results;
+    for (auto &[name, fn] : BenchRegistry::getInstance().getBenches())
+    {
+        if (name.find(filter) == string::npos)
+            continue;
+        if (list)
+        {
+            std::cout << name << "\n";
+            continue;
+        }
+        results.push_back(fn(minTime));
+        const auto &r = results.back();
+        std::cerr << std::left << std::setw(48) << r.name << std::right
+                  << std::fixed << std::setprecision(2) << std::setw(12)
+                  << r.mean * 1e6 << " us" << std::setw(10)
+                  << r.flops / r.mean / 1e9 << " GFLOP/s" << std::setw(10)
+                  << r.bytes / r.mean / 1e9 << " GB/s\n";
+    }
+    if (list)
+        return 0;
+
+    std::ofstream file(out);
+    if (!file)
+    {
+        std::cerr << "cannot open " << out << "\n";
+        return 1;
+    }
+    auto runtime = NativeCpuRuntimeObj::getInstance();
+    file << "{\n  \"context\": {\"simd\": \""
+         << simdLevelToString(getSimdLevel()) << "\", \"threads\": "
+         << runtime->getNumThreads() << "},\n  \"benchmarks\": [";
+    file << std::setprecision(6);
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const auto &r = results[i];
+        file << (i ? ",\n" : "\n") << "    {\"name\": \"" << r.name
+             << "\", \"iterations\": " << r.iterations
+             << ", \"mean_us\": " << r.mean * 1e6
+             << ", \"min_us\": " << r.min * 1e6
+             << ", \"gflops\": " << r.flops / r.mean / 1e9
+             << ", \"gbps\": " << r.bytes / r.mean / 1e9 << "}";
+    }
+    file << "\n  ]\n}\n";
+    std::cerr << "wrote " << results.size() << " results to " << out << "\n";
+    return 0;
+}
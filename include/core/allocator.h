@@ -6,6 +6,7 @@
 #endif
 #include <cstddef>
 #include <map>
+#include <set>
 #include <unordered_set>
 
 namespace infini {
@@ -23,11 +24,11 @@ namespace infini {
     // pointer to the memory actually allocated
     void *ptr;
 
-    // =================================== 作业 ===================================
-    // TODO：可能需要设计一个数据结构来存储free block，以便于管理和合并
-    // HINT: 可以使用一个 map 来存储 free block，key 为 block 的起始/结尾地址，value 为 block 的大小
-    // =================================== 作业 ===================================
-    std::map<size_t, size_t> addrBlocks;
+    // free blocks keyed by head address offset, used to merge neighbours
+    std::map<size_t, size_t> freeBlocks;
+
+    // the same free blocks ordered by (size, addr), used for best-fit lookup
+    std::set<std::pair<size_t, size_t>> freeBlocksBySize;
 
   public:
     Allocator(Runtime runtime);
@@ -52,9 +53,17 @@ namespace infini {
 
     void info();
 
+    // function: external fragmentation of the arena
+    // return: share of free bytes outside the largest free block, in [0, 1)
+    double getFragmentation() const;
+
   private:
-    // function: memory alignment, rouned up
+    // function: memory alignment, rouned up, with 0 taking one unit
     // return: size of the aligned memory block
     size_t getAlignedSize(size_t size);
+
+    void insertFreeBlock(size_t addr, size_t size);
+
+    void eraseFreeBlock(std::map<size_t, size_t>::iterator it);
   };
 }
@@ -11,12 +11,18 @@ class BlobObj
 {
   Runtime runtime;
   void *ptr;
+  // whether ptr came from runtime->alloc() and goes back with the blob
+  bool owned;
 
 public:
-  BlobObj(Runtime runtime, void *ptr) : runtime(runtime), ptr(ptr) {}
+  BlobObj(Runtime runtime, void *ptr)
+      : runtime(runtime), ptr(ptr), owned(false) {}
   BlobObj(BlobObj &other) = delete;
   BlobObj &operator=(BlobObj const &) = delete;
-  ~BlobObj() {};
+  ~BlobObj();
+
+  // A blob of `size` bytes of its own, outside of any graph's arena.
+  static Ref<BlobObj> allocate(Runtime runtime, size_t size);
 
   template <typename T>
   T getPtr() const { return reinterpret_cast<T>(ptr); }
@@ -0,0 +1,82 @@
+#pragma once
+#include "core/plan.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace infini
+{
+
+    /**
+     * @brief Runs the entries of an ExecutionPlan on a fixed set of worker
+     * threads, so that independent branches of a graph overlap in time.
+     *
+     * An entry becomes ready once all of its predecessors have finished. A
+     * worker pushes the entries it makes ready onto its own deque and pops
+     * from the back, keeping a producer and its consumer on the same core;
+     * idle workers steal from the front of the other deques. The calling
+     * thread takes part as worker 0, the others are started once and sleep
+     * between runs.
+     *
+     * Kernels keep parallelizing their loops on the runtime's ThreadPool,
+     * which takes jobs from all the workers at once.
+     */
+    class InterOpExecutor
+    {
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<size_t> tasks;
+        };
+
+        const int numThreads;
+        vector<std::thread> workers;
+        vector<std::unique_ptr<Queue>> queues;
+
+        // serializes run() calls, which share all the state below
+        std::mutex runMutex;
+
+        std::mutex mutex;
+        std::condition_variable wake, ready, done;
+        size_t generation = 0;
+        int active = 0;
+        bool stopping = false;
+
+        // state of the current run
+        const ExecutionPlan *plan = nullptr;
+        Profiler *profiler = nullptr;
+        std::unique_ptr<std::atomic<int>[]> pending;
+        std::atomic<size_t> remaining{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+
+        void workerLoop(int id);
+        void work(int id);
+        void push(int id, size_t task);
+        bool pop(int id, size_t &task);
+
+    public:
+        /**
+         * @param numThreads Number of workers including the caller; 0 uses
+         * one per hardware thread.
+         */
+        explicit InterOpExecutor(int numThreads = 0);
+        ~InterOpExecutor();
+        InterOpExecutor(const InterOpExecutor &) = delete;
+        InterOpExecutor &operator=(const InterOpExecutor &) = delete;
+
+        /**
+         * @brief Runs every entry of `plan` once and returns when all have
+         * finished. The first exception thrown by a kernel stops the
+         * scheduling of new entries and is rethrown here. Entries are timed
+         * into `profiler` when it is set, on the row of their worker.
+         */
+        void run(const ExecutionPlan &plan, Profiler *profiler = nullptr);
+
+        int getNumThreads() const { return numThreads; }
+    };
+
+} // namespace infini
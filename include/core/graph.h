@@ -1,18 +1,34 @@
 #pragma once
 #include "core/allocator.h"
 #include "core/operator.h"
+#include "core/schedule.h"
 #include "core/tensor.h"
+#include <unordered_map>
 
 namespace infini
 {
 
+    class ExecutionPlan;
+
     class GraphObj : public Object
     {
     protected:
         Runtime runtime;
-        TensorVec tensors;
-        OpVec ops;
+        // Removal leaves a null slot behind, so that it costs O(1) and the
+        // order of the rest is kept; compact() squeezes the slots out before
+        // the vectors are read.
+        mutable TensorVec tensors;
+        mutable OpVec ops;
+        // the slot of every tensor and operator in the vectors above, and
+        // the tensors by fuid
+        mutable std::unordered_map<TensorObj *, size_t> tensorSlots;
+        mutable std::unordered_map<OperatorObj *, size_t> opSlots;
+        std::unordered_map<UidBaseType, Tensor> tensorsByFuid;
+        mutable size_t removedTensors = 0, removedOps = 0;
         Allocator allocator;
+        // compiled lazily by getPlan(), dropped by everything that changes
+        // the ops, their shapes or their data blobs
+        Ref<ExecutionPlan> plan;
 
     public:
         explicit GraphObj(Runtime runtime)
@@ -23,22 +39,29 @@ namespace infini
         Tensor addTensor(Shape dim, DataType dtype = DataType::Float32);
         Tensor addTensor(const Tensor &tensor);
         TensorVec addTensor(const TensorVec &tensors);
-        void removeOperator(Operator op)
+        // Drop `op` / `tensor` from the graph in O(1), leaving their links
+        // untouched. Nothing happens if they are not in the graph.
+        void removeOperator(const Operator &op);
+        void removeTensor(const Tensor &tensor);
+
+        const TensorVec &getTensors() const
         {
-            auto it = std::find(ops.begin(), ops.end(), op);
-            if (it != ops.end())
-                ops.erase(it);
+            compact();
+            return tensors;
         }
-
-        void removeTensor(Tensor tensor)
+        const OpVec &getOperators() const
         {
-            auto it = std::find(tensors.begin(), tensors.end(), tensor);
-            if (it != tensors.end())
-                tensors.erase(it);
+            compact();
+            return ops;
+        }
+        bool hasTensor(const Tensor &tensor) const
+        {
+            return tensorSlots.count(tensor.get());
+        }
+        bool hasOperator(const Operator &op) const
+        {
+            return opSlots.count(op.get());
         }
-
-        const TensorVec &getTensors() const { return tensors; }
-        const OpVec &getOperators() const { return ops; }
         Tensor getTensor(int) const;
 
         /**
@@ -49,12 +72,37 @@ namespace infini
          */
         bool topo_sort();
 
+        /**
+         * @brief Reorders the operators to lower the peak bytes of live
+         * tensors once dataMalloc() reuses dead ones, see
+         * scheduleForMemory(). The order is kept if none is better.
+         */
+        ScheduleReport schedule(size_t exactLimit = 16);
+
+        /**
+         * @brief Applies defaultRewriteRules() to a fixed point, then
+         * schedule(). Constant folding only sees graph inputs already
+         * marked with TensorObj::setConstant() and holding their data;
+         * inputs marked or filled later stay regular inputs.
+         */
         void optimize();
 
         void shape_infer();
 
         void dataMalloc();
 
+        /**
+         * @brief Gets the execution plan of the graph, sorting and compiling
+         * it first if needed. The data must be allocated.
+         */
+        const ExecutionPlan &getPlan();
+
+        /**
+         * @brief Drops the cached plan. Needed only after changing tensors
+         * behind the graph's back, e.g. with TensorObj::setDataBlob.
+         */
+        void invalidatePlan() { plan.reset(); }
+
         /**
          * @brief Add an operator and create its outputs. Output tensor arguments
          * should be empty Refs (e.g., nullptr).
@@ -84,7 +132,7 @@ namespace infini
         inline TensorVec getInputs() const
         {
             TensorVec ret;
-            for (const auto &t : tensors)
+            for (const auto &t : getTensors())
                 if (!t->getSource())
                     ret.emplace_back(t);
             return ret;
@@ -96,7 +144,7 @@ namespace infini
         inline TensorVec getOutputs() const
         {
             TensorVec ret;
-            for (const auto &t : tensors)
+            for (const auto &t : getTensors())
                 if (t->getTargets().empty())
                     ret.emplace_back(t);
             return ret;
@@ -104,7 +152,45 @@ namespace infini
 
         bool checkValid() const;
 
+        // Rewrite helpers. Each keeps tensor source/targets and operator
+        // predecessor/successor links consistent, so a rewrite composed of
+        // them leaves a graph that passes checkValid().
+
+        /**
+         * @brief Makes `op` read `newInput` wherever it reads `oldInput`. If
+         * that was the last use of `oldInput`, the ops computing only dead
+         * tensors are erased too.
+         */
+        void replaceInput(const Operator &op, const Tensor &oldInput,
+                          const Tensor &newInput);
+
+        /**
+         * @brief Redirects every consumer of `oldTensor` to `newTensor`.
+         * `oldTensor` must not be a graph output.
+         */
+        void replaceAllUses(const Tensor &oldTensor, const Tensor &newTensor);
+
+        /**
+         * @brief Makes `op` write `newOutput`, which must have no producer,
+         * instead of `oldOutput`. `oldOutput` keeps its consumers but is
+         * left without a producer until another op is added to write it.
+         */
+        void replaceOutput(const Operator &op, const Tensor &oldOutput,
+                           const Tensor &newOutput);
+
+        /**
+         * @brief Removes `op` and its outputs, which must be unused, then
+         * everything upstream that is left without a consumer.
+         */
+        void eraseOperator(const Operator &op);
+
     private:
+        // Squeezes the slots of removed tensors and operators out.
+        void compact() const;
+
+        // Erases what computes `tensor` if it has just lost its last use.
+        void eraseIfDead(const Tensor &tensor);
+
         /**
          * @brief Add reverse connections and Op relationship in ctor.
          */
@@ -1,14 +1,18 @@
 #pragma once
 #include "core/common.h"
 #include "core/operator.h"
+#include "core/runtime.h"
 #include "core/tensor.h"
+#include "core/thread_pool.h"
 #include "utils/operator_utils.h"
 #include <functional>
 
 namespace infini
 {
 
-    class RuntimeObj;
+    // Runs one operator with everything its kernel derives from the op
+    // (casts, shapes, strides, data pointers) resolved ahead of time.
+    using KernelRoutine = std::function<void()>;
 
     class Kernel
     {
@@ -21,6 +25,18 @@ namespace infini
          */
         virtual void compute(const Operator &op,
                              const RuntimeObj *context) const = 0;
+
+        /**
+         * @brief Resolves an op into a routine for repeated execution. The
+         * routine stays valid as long as the shapes and the data blobs of the
+         * op's tensors do not change. The default one calls compute().
+         */
+        virtual KernelRoutine compile(const Operator &op,
+                                      const RuntimeObj *context) const
+        {
+            return [this, op, context]
+            { compute(op, context); };
+        }
     };
 
     class KernelRegistry
@@ -70,6 +86,15 @@ namespace infini
     public:
         virtual void compute(const Operator &op,
                              const RuntimeObj *context) const = 0;
+
+    protected:
+        // The pool kernels run their parallel loops on. Routines look it up
+        // on every call, since the runtime may restart it between runs.
+        static ThreadPool &getThreadPool(const RuntimeObj *context)
+        {
+            return static_cast<const NativeCpuRuntimeObj *>(context)
+                ->getThreadPool();
+        }
     };
 
 } // namespace infini
@@ -75,6 +75,7 @@ namespace infini
         void removePredecessors(const Operator &op);
         void removeSuccessors(const Operator &op);
         void replaceInput(Tensor t1, Tensor t2);
+        void replaceOutput(Tensor t1, Tensor t2);
     };
 
 #define OP_CLONE(OpObj)                                                \
@@ -0,0 +1,65 @@
+#pragma once
+#include "core/kernel.h"
+#include <mutex>
+
+namespace infini
+{
+
+    class Profiler;
+
+    /**
+     * @brief A sorted graph frozen into a flat array of operators, each with
+     * its kernel looked up and compiled once. Running the plan skips the
+     * registry lookups and the per-call setup of the kernels.
+     *
+     * A plan is only valid for the shapes and the data blobs it was compiled
+     * with; GraphObj drops its cached plan whenever either may change.
+     *
+     * Besides the sequential order, every entry records which entries must
+     * finish before it may start: the producers of its inputs and, because
+     * dataMalloc() lets a tensor reuse the block of one that died earlier,
+     * every reader of a block it is about to overwrite. Any order respecting
+     * these edges computes the same result as run(). Only concurrent
+     * execution needs them, so they are built on the first call of
+     * getEntriesWithDependencies().
+     */
+    class ExecutionPlan
+    {
+    public:
+        struct Entry
+        {
+            Operator op;
+            Kernel *kernel;
+            // as registered in the KernelRegistry
+            string kernelName;
+            KernelRoutine routine;
+            // entries that wait on this one, and how many this one waits
+            // on; empty until getEntriesWithDependencies() is called
+            vector<size_t> successors;
+            int numPredecessors;
+        };
+
+    private:
+        // the dependencies are filled in lazily, from const accessors
+        mutable vector<Entry> entries;
+        mutable std::once_flag dependenciesBuilt;
+
+        void buildDependencies() const;
+
+    public:
+        /**
+         * @brief Compiles `ops`, which must be in topological order and have
+         * their data allocated.
+         */
+        ExecutionPlan(const OpVec &ops, const RuntimeObj *runtime);
+
+        // Runs the entries in order, timing each one if `profiler` is set.
+        void run(Profiler *profiler = nullptr) const;
+
+        const vector<Entry> &getEntries() const { return entries; }
+        // The entries with their successors and predecessor counts, built
+        // once in O((E + B) log B) for E graph edges and B produced blocks.
+        const vector<Entry> &getEntriesWithDependencies() const;
+    };
+
+} // namespace infini
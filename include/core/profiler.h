@@ -0,0 +1,65 @@
+#pragma once
+#include "core/plan.h"
+#include <chrono>
+#include <mutex>
+
+namespace infini
+{
+
+    /**
+     * @brief Collects one record per operator execution while a runtime is
+     * profiling. Records can be aggregated into a table per kernel, or
+     * written as a Chrome trace_event file for chrome://tracing and Perfetto.
+     *
+     * Recording is thread-safe, so the workers of an InterOpExecutor report
+     * into the same profiler, each on its own trace row.
+     */
+    class Profiler
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Record
+        {
+            string kernel;
+            OpType opType;
+            UidBaseType guid;
+            vector<Shape> inputs, outputs;
+            // microseconds since the profiler was created or cleared
+            double start, duration;
+            int thread;
+            // estimates: arithmetic operations, and bytes read plus written
+            double flops, bytes;
+        };
+
+    private:
+        Clock::time_point origin;
+        vector<Record> records;
+        mutable std::mutex mutex;
+
+    public:
+        Profiler() : origin(Clock::now()) {}
+
+        void record(const ExecutionPlan::Entry &entry, Clock::time_point begin,
+                    Clock::time_point end, int thread);
+        // Runs the routine of `entry` and records it.
+        void time(const ExecutionPlan::Entry &entry, int thread);
+
+        vector<Record> getRecords() const;
+        void clear();
+
+        /**
+         * @brief A table with one row per kernel, sorted by total time: calls,
+         * total and mean time, share of the total, GFLOP/s and GB/s.
+         */
+        string summary() const;
+        // The records as a Chrome trace_event JSON document.
+        string toChromeTrace() const;
+        void dumpChromeTrace(const string &path) const;
+
+        // Estimated arithmetic and memory traffic of one run of `op`.
+        static double estimateFlops(const Operator &op);
+        static double estimateBytes(const Operator &op);
+    };
+
+} // namespace infini
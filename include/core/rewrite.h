@@ -0,0 +1,76 @@
+#pragma once
+#include "core/graph.h"
+#include <functional>
+
+namespace infini
+{
+
+    /**
+     * @brief A local rewrite of the graph, anchored at one operator: the
+     * root of the pattern. `match` inspects the root and whatever around it
+     * the pattern needs, without changing anything; `rewrite` is only called
+     * after a successful match and replaces the matched subgraph.
+     *
+     * Rewrites must go through the GraphObj helpers (replaceInput,
+     * replaceAllUses, eraseOperator, addOp...), which keep the tensor and
+     * operator links consistent. They may erase the root.
+     */
+    struct RewriteRule
+    {
+        string name;
+        // only operators of this type are offered to `match`; Unknown offers
+        // every operator
+        OpType root = OpType::Unknown;
+        std::function<bool(const Operator &)> match;
+        std::function<void(GraphObj &, const Operator &)> rewrite;
+    };
+
+    /**
+     * @brief Applies a list of rules to a graph until none of them matches.
+     *
+     * Each round walks the operators in topological order and offers every
+     * operator to the rules in the order they were added; the first rule
+     * that matches rewrites it, and the walk goes on with the next operator
+     * still in the graph. Rounds repeat until one changes nothing.
+     */
+    class PassManager
+    {
+    public:
+        struct RuleStats
+        {
+            // calls of `match`, and how many of them matched
+            size_t attempts = 0, applied = 0;
+        };
+
+    private:
+        vector<RewriteRule> rules;
+        vector<RuleStats> stats;
+        // runs that ran out of rounds while rules still applied
+        size_t cutOffRuns = 0;
+
+    public:
+        PassManager() = default;
+        explicit PassManager(vector<RewriteRule> rules);
+
+        void add(RewriteRule rule);
+
+        /**
+         * @brief Rewrites `graph` to a fixed point, or gives up after
+         * `maxRounds` rounds. Returns the number of rewrites applied. A run
+         * whose last round still applied a rule has not been seen to
+         * converge: it is counted in getCutOffRuns() and the graph, though
+         * valid, may not be fully rewritten.
+         */
+        size_t run(GraphObj &graph, size_t maxRounds = 16);
+
+        const vector<RewriteRule> &getRules() const { return rules; }
+        // Accumulated over every run(), in the order of getRules().
+        const vector<RuleStats> &getStats() const { return stats; }
+        size_t getCutOffRuns() const { return cutOffRuns; }
+        string statsToString() const;
+    };
+
+    // The rules GraphObj::optimize() applies.
+    vector<RewriteRule> defaultRewriteRules();
+
+} // namespace infini
@@ -10,6 +10,9 @@ namespace infini
   class GraphObj;
   class RuntimeObj;
   class BlobObj;
+  class InterOpExecutor;
+  class ThreadPool;
+  class Profiler;
 
   using Tensor = Ref<TensorObj>;
   using Operator = Ref<OperatorObj>;
@@ -45,14 +48,42 @@ namespace infini
     {
       return true;
     }
+    Device getDevice() const { return device; }
 
     virtual string toString() const = 0;
   };
 
+  /**
+   * @brief How NativeCpuRuntimeObj::alloc() obtains memory. Nothing is
+   * zeroed: every tensor is written before it is read.
+   */
+  struct CpuAllocPolicy
+  {
+    // a power of two; blocks of a page or more are page aligned anyway
+    size_t alignment = 64;
+    // blocks of at least HUGE_PAGE_BYTES are aligned to it and advised with
+    // MADV_HUGEPAGE, so that transparent huge pages may back them
+    bool hugePages = false;
+    // the intra-op workers touch every page before alloc() returns, so the
+    // page faults are taken in parallel and near the threads using them
+    bool prefault = false;
+  };
+
+  // Size of a transparent huge page on x86-64 and most aarch64 kernels.
+  constexpr size_t HUGE_PAGE_BYTES = size_t(2) << 20;
+
   class NativeCpuRuntimeObj : public RuntimeObj
   {
+    // shared by the kernels for their parallel loops
+    Ref<ThreadPool> threadPool;
+    // set when independent operators may run concurrently
+    Ref<InterOpExecutor> executor;
+    Ref<Profiler> profiler;
+    bool profiling = false;
+    CpuAllocPolicy allocPolicy;
+
   public:
-    NativeCpuRuntimeObj() : RuntimeObj(Device::CPU) {}
+    NativeCpuRuntimeObj();
 
     static Ref<NativeCpuRuntimeObj> &getInstance()
     {
@@ -62,6 +93,32 @@ namespace infini
     }
     void dealloc(void *ptr) override;
     void run(const Graph &graph) const override;
+    /**
+     * @brief Runs the operators of a graph on `n` threads, each starting as
+     * soon as its inputs are ready. 0 uses one thread per hardware thread;
+     * 1 restores the default sequential execution.
+     */
+    void setInterOpThreads(int n);
+    int getInterOpThreads() const;
+    /**
+     * @brief Restarts the intra-op thread pool with `n` threads, 0 meaning
+     * INFINI_NUM_THREADS or one per hardware thread. Workers are pinned to
+     * the CPUs in `affinity` when it is not empty. Must not be called while
+     * a graph is running.
+     */
+    void setNumThreads(int n, const vector<int> &affinity = {});
+    int getNumThreads() const;
+    ThreadPool &getThreadPool() const { return *threadPool; }
+    /**
+     * @brief While enabled, run() times every operator into getProfiler().
+     * Disabling keeps the records collected so far.
+     */
+    void setProfiling(bool enable) { profiling = enable; }
+    bool isProfiling() const { return profiling; }
+    Profiler &getProfiler() const { return *profiler; }
+    // Applies to the blocks allocated from now on.
+    void setAllocPolicy(const CpuAllocPolicy &policy);
+    const CpuAllocPolicy &getAllocPolicy() const { return allocPolicy; }
     void *alloc(size_t size) override;
     string toString() const override;
   };
@@ -0,0 +1,36 @@
+#pragma once
+#include "core/operator.h"
+
+namespace infini
+{
+
+    /**
+     * @brief Peak bytes of the tensors live while `ops` run in this order,
+     * freeing each intermediate tensor after its last consumer as
+     * GraphObj::dataMalloc does. Graph inputs are live throughout, graph
+     * outputs from their producer on, and constants are not counted.
+     * Alignment and fragmentation of the arena are ignored, and outputs
+     * dataMalloc() places over a dying input or inside a concat output
+     * still count as tensors of their own.
+     */
+    size_t peakLiveBytes(const OpVec &ops);
+
+    /**
+     * @brief Reorders `ops`, which must be in a topological order, into
+     * another one with a smaller peakLiveBytes().
+     *
+     * Graphs of at most `exactLimit` operators (capped at 20) get an optimal
+     * order from a search over the sets of operators already run. Larger
+     * ones are scheduled greedily: of the ready operators, the one growing
+     * the live bytes the least (or shrinking them the most) runs next, ties
+     * going to the earliest in `ops`.
+     */
+    OpVec scheduleForMemory(const OpVec &ops, size_t exactLimit = 16);
+
+    struct ScheduleReport
+    {
+        // peakLiveBytes() of the order before and after scheduling
+        size_t peakBefore = 0, peakAfter = 0;
+    };
+
+} // namespace infini
@@ -24,9 +24,14 @@ namespace infini
         WRef<OperatorObj> source;
         Blob data;
         Runtime runtime;
+        bool constant = false;
 
     private:
         Shape shape;
+        // Element strides and byte offset of the data in `data`; row-major
+        // and 0 unless the tensor is a view of another tensor's blob.
+        Shape strides;
+        size_t offset = 0;
         size_t _size; // Cache of Π(shape).
         Fuid fuid;    // Cloned tensors share the same id. Tensors constructed from
                       // scratch have a new id.
@@ -47,7 +52,33 @@ namespace infini
         void setData(
             std::function<void(void *, size_t, DataType)> const &generator) const;
 
+        // Binds dense row-major storage.
         void setDataBlob(const Blob &blob);
+        Blob getDataBlob() const { return data; }
+
+        /**
+         * @brief Makes the tensor a view of `blob`: element (i0, i1, ...)
+         * is found `offset` bytes plus Σ ik * strides[k] elements into it.
+         * Only kernels that read strided inputs may be given such a tensor.
+         */
+        void setView(const Blob &blob, Shape strides, size_t offset);
+        Shape getStrides() const { return strides; }
+        size_t getOffset() const { return offset; }
+        // Whether the elements are laid out densely in row-major order.
+        bool isContiguous() const;
+
+        /**
+         * @brief Marks a graph input as constant, e.g. a weight. It gets
+         * storage of its own, outside the graph's arena, so its data can be
+         * set before dataMalloc().
+         *
+         * This is the only way optimize() learns that a tensor is constant:
+         * it folds the ops that read nothing but tensors marked here, with
+         * the data they hold at that point. So call it, and set the data,
+         * before optimize(); data set on ordinary inputs is never folded.
+         */
+        void setConstant();
+        bool isConstant() const { return constant; }
 
         void printData() const;
         bool equalData(const Tensor &rhs, double relativeError = 1e-6) const;
@@ -56,6 +87,7 @@ namespace infini
         bool equalData(const vector<T> &dataVector)
         {
             IT_ASSERT(size() == dataVector.size());
+            IT_ASSERT(isContiguous());
             IT_ASSERT(DataType::get<T>() == dtype.cpuTypeInt());
             return equalDataImpl(getRawDataPtr<T *>(), dataVector.data(), size());
         }
@@ -66,7 +98,7 @@ namespace infini
             static_assert(std::is_pointer_v<T>,
                           "Raw data pointer has a type of pointer");
             IT_ASSERT(data != nullptr);
-            return data->getPtr<T>();
+            return reinterpret_cast<T>(data->getPtr<char *>() + offset);
         }
 
         DataType getDType() const { return dtype; }
@@ -84,7 +116,7 @@ namespace infini
 
             auto numDims = shape.size();
             auto dimSzVec = vector<int>(numDims, 1);
-            auto ptr = data->getPtr<T *>();
+            auto ptr = getRawDataPtr<T *>();
             dimSzVec[numDims - 1] = shape[numDims - 1];
 
             for (int i = numDims - 1; i != 0; --i)
@@ -0,0 +1,79 @@
+#pragma once
+#include "core/common.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace infini
+{
+
+    /**
+     * @brief Worker threads started once and shared by all the CPU kernels
+     * of a runtime, so a parallel loop costs a wake-up instead of a
+     * fork/join of a fresh team.
+     *
+     * parallel_for() may be called from several threads at once, including
+     * from inside another parallel_for() and from the workers of an
+     * InterOpExecutor: every call is queued as a job, idle workers take
+     * chunks from the oldest job, and the caller works on its own job until
+     * no chunk is left, so a call never waits on an unrelated one.
+     */
+    class ThreadPool
+    {
+    public:
+        // Called with a half-open range [begin, end) of the iteration space.
+        using Body = std::function<void(size_t, size_t)>;
+
+    private:
+        struct Job
+        {
+            const Body *body;
+            size_t begin, end, chunk, numChunks;
+            std::atomic<size_t> next{0}, finished{0};
+            // workers that picked the job and may still touch it
+            int users = 0;
+            std::exception_ptr error;
+        };
+
+        const int numThreads;
+        vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake, done;
+        // jobs that may still have unclaimed chunks, oldest first
+        std::deque<Job *> jobs;
+        bool stopping = false;
+
+        void workerLoop(int cpu);
+        bool runChunk(Job &job);
+
+    public:
+        /**
+         * @param numThreads Threads taking part in a loop, the caller
+         * included; 0 reads INFINI_NUM_THREADS and falls back to one per
+         * hardware thread.
+         * @param affinity CPUs to pin the workers to; empty leaves them
+         * unpinned. The caller is thread 0 and is never pinned, so worker
+         * thread i (1 <= i < numThreads) goes to
+         * affinity[(i - 1) % affinity.size()].
+         */
+        explicit ThreadPool(int numThreads = 0, const vector<int> &affinity = {});
+        ~ThreadPool();
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        int getNumThreads() const { return numThreads; }
+
+        /**
+         * @brief Runs body over [begin, end) cut into contiguous chunks of at
+         * least `grain` iterations, and returns when all chunks are done.
+         * Ranges that fit in one chunk run inline on the caller. The first
+         * exception thrown by the body is rethrown here.
+         */
+        void parallel_for(size_t begin, size_t end, size_t grain,
+                          const Body &body);
+    };
+
+} // namespace infini
@@ -28,5 +28,7 @@ class ConcatObj : public OperatorObj {
     int numInputs() const override { return inputs.size(); }
     int numOutputs() const override { return 1; }
     int getDim() const { return dim; }
+    // The caller keeps the output shape consistent.
+    void setDim(int dim_) { dim = dim_; }
 };
 } // namespace infini
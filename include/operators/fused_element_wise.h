@@ -0,0 +1,48 @@
+#pragma once
+#include "core/operator.h"
+#include <cmath>
+
+namespace infini
+{
+  /**
+   * @brief One step of a FusedElementwiseObj program. Registers
+   * 0..numInputs-1 hold the inputs, and step i writes register
+   * numInputs + i.
+   */
+  struct ElementwiseInstr
+  {
+    // Add, Sub, Mul, Div, Relu or Clip
+    OpType type;
+    // operand registers; rhs is -1 for Relu and Clip
+    int lhs, rhs = -1;
+    // bounds of a Clip
+    float min = -INFINITY, max = INFINITY;
+  };
+
+  // fuse-elementwise stops growing a program at this many steps, so a long
+  // chain becomes several FusedElementwise ops rather than one whose rewrites
+  // copy an ever longer program.
+  constexpr size_t MAX_FUSED_PROGRAM = 32;
+
+  /**
+   * @brief A chain (or tree) of element-wise operators evaluated in one pass
+   * over memory. The inputs broadcast against each other as in
+   * ElementWiseObj, and the output is the register of the last step.
+   *
+   */
+  class FusedElementwiseObj : public OperatorObj
+  {
+    vector<ElementwiseInstr> program;
+
+  public:
+    FusedElementwiseObj(GraphObj *graph, TensorVec inputs, Tensor output,
+                        vector<ElementwiseInstr> program);
+    OP_CLONE(FusedElementwiseObj);
+    optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+
+    std::string toString() const override;
+    int numInputs() const override { return inputs.size(); }
+    int numOutputs() const override { return 1; }
+    const vector<ElementwiseInstr> &getProgram() const { return program; }
+  };
+}; // namespace infini
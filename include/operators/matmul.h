@@ -15,6 +15,12 @@ namespace infini
         // oppsite to the column-major BLAS.
         bool transA, transB;
 
+        // Optional epilogue, applied to every element of A * B before it is
+        // stored: C = clamp(A * B + bias + residual, minValue, maxValue).
+        // The bias and the residual, if any, follow A and B in the inputs.
+        bool hasBias = false, hasResidual = false;
+        std::optional<float> minValue, maxValue;
+
         // Auxiliary attributes which are not a part of operator attributes.
         int m, n, k;
 
@@ -40,6 +46,18 @@ namespace infini
          */
         MatmulObj(GraphObj *graph, Tensor A, Tensor B, Tensor C,
                   bool transA = false, bool transB = false);
+
+        /**
+         * @brief Matmul with a fused epilogue, as built by the fusion pass.
+         *
+         * @param bias Null, or N elements, all leading dims of size 1, added
+         * to every row of C.
+         * @param residual Null, or a tensor with the shape of C, added to it.
+         * @param min,max Clamp bounds applied last; Relu is min = 0.
+         */
+        MatmulObj(GraphObj *graph, Tensor A, Tensor B, Tensor C, bool transA,
+                  bool transB, Tensor bias, Tensor residual,
+                  std::optional<float> min, std::optional<float> max);
         OP_CLONE(MatmulObj);
 
         std::string toString() const override;
@@ -52,6 +70,17 @@ namespace infini
         bool getTransB() const { return transB; }
         void setTransA(bool transA) { this->transA = transA; }
         void setTransB(bool transB) { this->transB = transB; }
+        Tensor getBias() const { return hasBias ? inputs[2] : nullptr; }
+        Tensor getResidual() const
+        {
+            return hasResidual ? inputs[2 + hasBias] : nullptr;
+        }
+        std::optional<float> getMin() const { return minValue; }
+        std::optional<float> getMax() const { return maxValue; }
+        bool hasEpilogue() const
+        {
+            return hasBias || hasResidual || minValue || maxValue;
+        }
         int getM() const { return m; }
         int getN() const { return n; }
         int getK() const { return k; }
@@ -27,6 +27,8 @@ namespace infini
     int numInputs() const override { return 1; }
     int numOutputs() const override { return 1; }
     std::vector<int> getPermute() const { return transposePermute; }
+    // The caller keeps the output shape consistent.
+    void setPermute(vector<int> permute) { transposePermute = permute; }
 
   private:
     vector<int> transposePermute;
@@ -0,0 +1,21 @@
+#pragma once
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+namespace infini {
+
+// Instruction set levels that CPU kernels can be specialized for, ordered
+// from the weakest to the strongest. AVX2 implies FMA and F16C, AVX512 means
+// AVX-512 F, BW and VL.
+enum class SimdLevel { Scalar, SSE42, AVX2, AVX512 };
+
+// Highest SimdLevel supported by the host, detected once through CPUID. The
+// environment variable INFINI_SIMD (scalar, sse4.2, avx2 or avx512) caps the
+// level, which is how the fallback paths are exercised on newer hosts.
+SimdLevel getSimdLevel();
+
+const char *simdLevelToString(SimdLevel level);
+
+} // namespace infini
+
+#endif
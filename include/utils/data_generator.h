@@ -1,5 +1,7 @@
 #pragma once
 #include "core/common.h"
+#include "core/data_type.h"
+#include "utils/half.h"
 #include <random>
 
 namespace infini {
@@ -16,7 +18,17 @@ public:
             fill(reinterpret_cast<uint32_t *>(data), size);
         else if (dataType == DataType::Float32)
             fill(reinterpret_cast<float *>(data), size);
-        else
+        else if (dataType == DataType::Float16 ||
+                 dataType == DataType::BFloat16) {
+            // generated in Float32, then rounded to the 16-bit format
+            vector<float> values(size);
+            fill(values.data(), size);
+            auto ptr = reinterpret_cast<uint16_t *>(data);
+            for (size_t i = 0; i < size; ++i)
+                ptr[i] = dataType == DataType::Float16
+                             ? float_to_half(values[i])
+                             : float_to_bfloat16(values[i]);
+        } else
             IT_TODO_HALT();
     }
 };
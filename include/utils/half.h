@@ -0,0 +1,77 @@
+#pragma once
+#ifndef HALF_H
+#define HALF_H
+
+#include <cstdint>
+#include <cstring>
+
+namespace infini {
+
+// Scalar conversions between float and the 16-bit float formats, which are
+// stored as uint16_t (see DataType::Float16 and DataType::BFloat16). Both
+// narrowing conversions round to nearest even and keep NaN quiet.
+
+inline uint32_t float_as_bits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+inline float bits_as_float(uint32_t u) {
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+inline uint16_t float_to_half(float f) {
+    uint32_t u = float_as_bits(f);
+    uint32_t sign = (u >> 16) & 0x8000;
+    u &= 0x7FFFFFFF;
+    uint16_t h;
+    if (u >= (127 + 16) << 23) {
+        // overflows to Inf, NaN stays NaN
+        h = u > 0x7F800000 ? 0x7E00 : 0x7C00;
+    } else if (u < 113 << 23) {
+        // half subnormal or zero: let the float adder align and round the
+        // 10 mantissa bits
+        const uint32_t magic = ((127 - 15) + (23 - 10) + 1) << 23;
+        h = float_as_bits(bits_as_float(u) + bits_as_float(magic)) - magic;
+    } else {
+        uint32_t odd = (u >> 13) & 1;
+        u += ((uint32_t)(15 - 127) << 23) + 0xFFF + odd;
+        h = u >> 13;
+    }
+    return h | sign;
+}
+
+inline float half_to_float(uint16_t h) {
+    const uint32_t shiftedExp = 0x7C00 << 13;
+    uint32_t u = (uint32_t)(h & 0x7FFF) << 13;
+    uint32_t exp = u & shiftedExp;
+    u += (127 - 15) << 23;
+    if (exp == shiftedExp) {
+        // Inf or NaN
+        u += (128 - 16) << 23;
+    } else if (exp == 0) {
+        // zero or subnormal: renormalize through the float unit
+        u += 1 << 23;
+        u = float_as_bits(bits_as_float(u) - bits_as_float(113 << 23));
+    }
+    return bits_as_float(u | (uint32_t)(h & 0x8000) << 16);
+}
+
+inline uint16_t float_to_bfloat16(float f) {
+    uint32_t u = float_as_bits(f);
+    if ((u & 0x7FFFFFFF) > 0x7F800000)
+        return (u >> 16) | 0x40;
+    u += 0x7FFF + ((u >> 16) & 1);
+    return u >> 16;
+}
+
+inline float bfloat16_to_float(uint16_t h) {
+    return bits_as_float((uint32_t)h << 16);
+}
+
+} // namespace infini
+
+#endif
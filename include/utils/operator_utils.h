@@ -18,6 +18,36 @@ Shape locate_index(size_t inputN, const Shape &shape);
 // Delocate the ShapeIndex from Shape with broadcast
 size_t delocate_index(const Shape &shapeIndex, const Shape &shape,
                       const Shape &stride);
+// Pad the input shapes to the rank of the broadcast output `shape`, drop unit
+// dims and merge adjacent dims that every input either spans or broadcasts
+// together. All shapes are rewritten in place and keep the same rank.
+void collapse_broadcast(Shape &shape, vector<Shape> &inputs);
+// Element strides of an input in a broadcast against `shape` of equal rank,
+// with 0 for the broadcast dims
+Shape broadcast_strides(const Shape &input, const Shape &shape);
+// Element strides of a tensor, which may be a strided view, in a broadcast
+// against `shape`: padded to its rank, with 0 for the broadcast dims
+Shape broadcast_strides(const Tensor &input, const Shape &shape);
+// Drop unit dims of `shape` and merge adjacent dims that every input walks
+// with a single stride. `strides` holds one stride vector per input, of the
+// rank of `shape`; all are rewritten in place and keep the same rank.
+void collapse_strides(Shape &shape, vector<Shape> &strides);
+
+// Walks the rows (all dims but the last) of a broadcast and keeps the element
+// offset of every input up to date without per-row divisions.
+class BroadcastRowIterator {
+    Shape shape;
+    vector<Shape> strides;
+    Shape index;
+    vector<size_t> offsets;
+
+  public:
+    BroadcastRowIterator(const Shape &shape, const vector<Shape> &strides,
+                         size_t row);
+    size_t offset(size_t input) const { return offsets[input]; }
+    void next();
+};
+
 // Convert KernelAttrs to a string representation
 std::string get_kernel_attrs_str(const KernelAttrs &kernelAttrs);
 
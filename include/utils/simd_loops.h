@@ -0,0 +1,65 @@
+#pragma once
+#ifndef SIMD_LOOPS_H
+#define SIMD_LOOPS_H
+
+#include "core/data_type.h"
+#include "core/op_type.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace infini {
+
+// Loops of a binary element-wise op over one contiguous run of the output.
+// `vs` and `sv` take a scalar for the second and the first operand.
+template <typename T> struct BinaryLoops {
+    void (*vv)(T *out, const T *a, const T *b, size_t n);
+    void (*vs)(T *out, const T *a, T b, size_t n);
+    void (*sv)(T *out, T a, const T *b, size_t n);
+};
+
+using UnaryFloatLoop = void (*)(float *out, const float *in, size_t n);
+using ClipFloatLoop = void (*)(float *out, const float *in, size_t n,
+                               float minValue, float maxValue);
+
+// Float32 loops vectorized for the SimdLevel detected at startup. They
+// return nullptr on hosts without SSE4.2, where the kernels keep their
+// scalar loops. All loops are safe to run with `out` aliasing an input.
+const BinaryLoops<float> *getSimdBinaryLoops(OpType type);
+UnaryFloatLoop getSimdReluLoop();
+ClipFloatLoop getSimdClipLoop();
+
+// The same loops, never null: without SIMD support they fall back to
+// scalar loops. `type` is Add, Sub, Mul or Div.
+const BinaryLoops<float> &getFloatBinaryLoops(OpType type);
+UnaryFloatLoop getFloatReluLoop();
+ClipFloatLoop getFloatClipLoop();
+
+// Conversions between Float32 and the 16-bit float formats, which are stored
+// as uint16_t. Never null: below the levels with vector conversions (F16C
+// for Float16, SSE4.2 for BFloat16) they are the scalar loops of
+// utils/half.h. All paths round to nearest even; only NaN payloads may
+// differ between them.
+struct HalfConvertLoops {
+    void (*halfToFloat)(float *out, const uint16_t *in, size_t n);
+    void (*floatToHalf)(uint16_t *out, const float *in, size_t n);
+    void (*bfloat16ToFloat)(float *out, const uint16_t *in, size_t n);
+    void (*floatToBfloat16)(uint16_t *out, const float *in, size_t n);
+};
+const HalfConvertLoops &getHalfConvertLoops();
+
+// Kernels compute Float16 and BFloat16 data in Float32, widening and
+// narrowing at most this many elements at a time through stack buffers.
+constexpr size_t HALF_BLOCK = 512;
+
+// The two conversion loops of one 16-bit float type.
+struct HalfFormat {
+    void (*toFloat)(float *out, const uint16_t *in, size_t n);
+    void (*fromFloat)(uint16_t *out, const float *in, size_t n);
+};
+
+// `dtype` must be DataType::Float16 or DataType::BFloat16.
+HalfFormat getHalfFormat(DataType dtype);
+
+} // namespace infini
+
+#endif
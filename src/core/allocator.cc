@@ -28,64 +28,108 @@ namespace infini
         IT_ASSERT(this->ptr == nullptr);
         // pad the size to the multiple of alignment
         size = this->getAlignedSize(size);
-
-        // =================================== 作业 ===================================
-        // TODO: 设计一个算法来分配内存，返回起始地址偏移量
-        // =================================== 作业 ===================================
         this->used += size;
-        this->peak = std::max(this->peak, this->used);
 
-        size_t result_offset = 0;
-        if (this->addrBlocks.size() != 0)
+        // best fit: the smallest free block that is large enough
+        auto fit = this->freeBlocksBySize.lower_bound({size, 0});
+        if (fit != this->freeBlocksBySize.end())
+        {
+            auto [blockSize, addr] = *fit;
+            eraseFreeBlock(this->freeBlocks.find(addr));
+            if (blockSize > size)
+                insertFreeBlock(addr + size, blockSize - size);
+            return addr;
+        }
+
+        // no block fits: grow the free block at the tail of the arena if
+        // there is one, otherwise append a new block
+        size_t addr = this->peak;
+        if (!this->freeBlocks.empty())
         {
-            auto it = this->addrBlocks.begin();
-            size_t pre_end = it->first + it->second;
-            for (it ++; it != this->addrBlocks.end(); it++)
+            auto last = std::prev(this->freeBlocks.end());
+            if (last->first + last->second == this->peak)
             {
-                if (pre_end + size <= it->first)
-                {
-                    break;
-                }
-                pre_end = it->first + it->second;
+                addr = last->first;
+                eraseFreeBlock(last);
             }
-            result_offset = pre_end;
         }
-
-        // C++ 标准库中的 std::map 默认是按照 key 来排序的
-        this->addrBlocks[result_offset] = size;
-        return result_offset;
+        this->peak = addr + size;
+        return addr;
     }
 
     void Allocator::free(size_t addr, size_t size)
     {
         IT_ASSERT(this->ptr == nullptr);
         size = getAlignedSize(size);
-
-        // =================================== 作业 ===================================
-        // TODO: 设计一个算法来回收内存
-        // =================================== 作业 ===================================
+        IT_ASSERT(addr + size <= this->peak);
         this->used -= size;
-        this->addrBlocks.erase(addr);
+
+        // coalesce with the free neighbours on both sides
+        auto next = this->freeBlocks.lower_bound(addr);
+        IT_ASSERT(next == this->freeBlocks.end() || next->first >= addr + size,
+                  "Double free of block at " + std::to_string(addr));
+        if (next != this->freeBlocks.end() && next->first == addr + size)
+        {
+            size += next->second;
+            next = std::next(next);
+            eraseFreeBlock(std::prev(next));
+        }
+        if (next != this->freeBlocks.begin())
+        {
+            auto prev = std::prev(next);
+            IT_ASSERT(prev->first + prev->second <= addr,
+                      "Double free of block at " + std::to_string(addr));
+            if (prev->first + prev->second == addr)
+            {
+                addr = prev->first;
+                size += prev->second;
+                eraseFreeBlock(prev);
+            }
+        }
+        insertFreeBlock(addr, size);
+    }
+
+    void Allocator::insertFreeBlock(size_t addr, size_t size)
+    {
+        this->freeBlocks.emplace(addr, size);
+        this->freeBlocksBySize.emplace(size, addr);
+    }
+
+    void Allocator::eraseFreeBlock(std::map<size_t, size_t>::iterator it)
+    {
+        this->freeBlocksBySize.erase({it->second, it->first});
+        this->freeBlocks.erase(it);
     }
 
     void *Allocator::getPtr()
     {
         if (this->ptr == nullptr)
-        {
             this->ptr = runtime->alloc(this->peak);
-            printf("Allocator really alloc: %p %lu bytes\n", this->ptr, peak);
-        }
         return this->ptr;
     }
 
     size_t Allocator::getAlignedSize(size_t size)
     {
+        // an empty tensor still takes one unit, so its address is its own
+        // and freeing it cannot alias a neighbour
+        size = std::max<size_t>(size, 1);
         return ((size - 1) / this->alignment + 1) * this->alignment;
     }
 
+    double Allocator::getFragmentation() const
+    {
+        size_t freeBytes = this->peak - this->used;
+        if (freeBytes == 0 || this->freeBlocksBySize.empty())
+            return 0.;
+        size_t largest = this->freeBlocksBySize.rbegin()->first;
+        return 1. - static_cast<double>(largest) / freeBytes;
+    }
+
     void Allocator::info()
     {
         std::cout << "Used memory: " << this->used
-                  << ", peak memory: " << this->peak << std::endl;
+                  << ", peak memory: " << this->peak
+                  << ", free blocks: " << this->freeBlocks.size()
+                  << ", fragmentation: " << getFragmentation() << std::endl;
     }
 }
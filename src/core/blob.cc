@@ -0,0 +1,17 @@
+#include "core/blob.h"
+#include "core/runtime.h"
+
+namespace infini {
+
+BlobObj::~BlobObj() {
+  if (owned)
+    runtime->dealloc(ptr);
+}
+
+Ref<BlobObj> BlobObj::allocate(Runtime runtime, size_t size) {
+  auto blob = make_ref<BlobObj>(runtime, runtime->alloc(size));
+  blob->owned = true;
+  return blob;
+}
+
+} // namespace infini
@@ -0,0 +1,182 @@
+#include "core/executor.h"
+#include "core/profiler.h"
+#include <chrono>
+
+namespace infini
+{
+
+    // Failed pops an idle worker retries with a yield before it blocks.
+    constexpr int EXECUTOR_SPINS = 64;
+
+    InterOpExecutor::InterOpExecutor(int numThreads)
+        : numThreads(numThreads > 0
+                         ? numThreads
+                         : std::max(1u, std::thread::hardware_concurrency()))
+    {
+        for (int i = 0; i < this->numThreads; ++i)
+            queues.push_back(std::make_unique<Queue>());
+        for (int i = 1; i < this->numThreads; ++i)
+            workers.emplace_back(&InterOpExecutor::workerLoop, this, i);
+    }
+
+    InterOpExecutor::~InterOpExecutor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    void InterOpExecutor::run(const ExecutionPlan &plan, Profiler *profiler)
+    {
+        std::lock_guard<std::mutex> guard(runMutex);
+        const auto &entries = plan.getEntriesWithDependencies();
+        if (entries.empty())
+            return;
+
+        this->plan = &plan;
+        this->profiler = profiler;
+        pending = std::make_unique<std::atomic<int>[]>(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i)
+            pending[i].store(entries[i].numPredecessors,
+                             std::memory_order_relaxed);
+        remaining.store(entries.size(), std::memory_order_relaxed);
+        failed.store(false, std::memory_order_relaxed);
+        error = nullptr;
+        // deal the roots round-robin, stealing balances the rest
+        int next = 0;
+        for (size_t i = 0; i < entries.size(); ++i)
+            if (entries[i].numPredecessors == 0)
+            {
+                queues[next]->tasks.push_back(i);
+                next = (next + 1) % numThreads;
+            }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active = numThreads - 1;
+            ++generation;
+        }
+        wake.notify_all();
+
+        work(0);
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this]
+                      { return active == 0; });
+        }
+        for (auto &queue : queues)
+            queue->tasks.clear();
+        this->plan = nullptr;
+        this->profiler = nullptr;
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    void InterOpExecutor::workerLoop(int id)
+    {
+        size_t seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]
+                          { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+            }
+            work(id);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--active == 0)
+                    done.notify_all();
+            }
+        }
+    }
+
+    void InterOpExecutor::work(int id)
+    {
+        const auto &entries = plan->getEntries();
+        int idle = 0;
+        while (remaining.load(std::memory_order_acquire) > 0 &&
+               !failed.load(std::memory_order_relaxed))
+        {
+            size_t task;
+            if (!pop(id, task))
+            {
+                if (++idle < EXECUTOR_SPINS)
+                    std::this_thread::yield();
+                else
+                {
+                    // a push may slip in between the check and the wait, so
+                    // the wait is bounded
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ready.wait_for(lock, std::chrono::microseconds(100));
+                }
+                continue;
+            }
+            idle = 0;
+            try
+            {
+                if (profiler)
+                    profiler->time(entries[task], id);
+                else
+                    entries[task].routine();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                    error = std::current_exception();
+                failed.store(true, std::memory_order_relaxed);
+                break;
+            }
+            for (size_t succ : entries[task].successors)
+                if (pending[succ].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    push(id, succ);
+            remaining.fetch_sub(1, std::memory_order_acq_rel);
+        }
+        ready.notify_all();
+    }
+
+    void InterOpExecutor::push(int id, size_t task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queues[id]->mutex);
+            queues[id]->tasks.push_back(task);
+        }
+        ready.notify_one();
+    }
+
+    bool InterOpExecutor::pop(int id, size_t &task)
+    {
+        {
+            auto &own = *queues[id];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty())
+            {
+                task = own.tasks.back();
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (int k = 1; k < numThreads; ++k)
+        {
+            auto &victim = *queues[(id + k) % numThreads];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+} // namespace infini
@@ -1,9 +1,12 @@
 #include "core/graph.h"
-#include "operators/matmul.h"
+#include "core/plan.h"
+#include "core/rewrite.h"
+#include "operators/concat.h"
 #include "operators/transpose.h"
 #include <algorithm>
 #include <numeric>
 #include <queue>
+#include <unordered_set>
 
 namespace infini
 {
@@ -11,6 +14,9 @@ namespace infini
     void GraphObj::addOperatorAndConnect(const Operator &op)
     {
         sorted = false;
+        plan.reset();
+        IT_ASSERT(!hasOperator(op), "the operator is already in the graph");
+        opSlots[op.get()] = ops.size();
         ops.push_back(op);
         for (auto &input : op->getInputs())
         {
@@ -38,8 +44,59 @@ namespace infini
         }
     }
 
+    void GraphObj::removeOperator(const Operator &op)
+    {
+        auto it = opSlots.find(op.get());
+        if (it == opSlots.end())
+            return;
+        plan.reset();
+        ops[it->second] = nullptr;
+        opSlots.erase(it);
+        ++removedOps;
+    }
+
+    void GraphObj::removeTensor(const Tensor &tensor)
+    {
+        auto it = tensorSlots.find(tensor.get());
+        if (it == tensorSlots.end())
+            return;
+        plan.reset();
+        tensors[it->second] = nullptr;
+        tensorSlots.erase(it);
+        auto byFuid = tensorsByFuid.find(tensor->getFuid());
+        if (byFuid != tensorsByFuid.end() && byFuid->second == tensor)
+            tensorsByFuid.erase(byFuid);
+        ++removedTensors;
+    }
+
+    // Moves the live entries of `items` to the front, in order, and records
+    // their new slots.
+    template <typename T>
+    static void squeeze(vector<Ref<T>> &items,
+                        std::unordered_map<T *, size_t> &slots)
+    {
+        size_t n = 0;
+        for (auto &item : items)
+            if (item)
+            {
+                slots[item.get()] = n;
+                items[n++] = std::move(item);
+            }
+        items.resize(n);
+    }
+
+    void GraphObj::compact() const
+    {
+        if (removedTensors)
+            squeeze(tensors, tensorSlots);
+        if (removedOps)
+            squeeze(ops, opSlots);
+        removedTensors = removedOps = 0;
+    }
+
     string GraphObj::toString() const
     {
+        compact();
         std::ostringstream oss;
         oss << "Graph Tensors:\n";
         for (const auto &tensor : tensors)
@@ -63,163 +120,197 @@ namespace infini
 
     bool GraphObj::topo_sort()
     {
+        compact();
         if (this->sorted)
         {
             return true;
         }
+        // Kahn's algorithm: an op is ready once every input slot it reads
+        // from another op has been produced. The ready op that comes first
+        // in the current order goes next, so a valid order is kept as is.
+        std::unordered_map<OperatorObj *, size_t> pending;
+        pending.reserve(ops.size());
+        std::priority_queue<size_t, vector<size_t>, std::greater<size_t>> ready;
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            size_t count = 0;
+            for (auto const &input : ops[i]->getInputs())
+                count += input->getSource() != nullptr;
+            pending[ops[i].get()] = count;
+            if (count == 0)
+                ready.push(i);
+        }
         std::vector<Operator> sorted;
-        std::unordered_set<OperatorObj *> flags;
         sorted.reserve(ops.size());
-        flags.reserve(ops.size());
-        while (sorted.size() < ops.size())
+        while (!ready.empty())
         {
-            // Any node is move to sorted in this loop.
-            auto modified = false;
-            for (auto const &op : ops)
-            {
-                if (auto const &inputs = op->getInputs();
-                    flags.find(op.get()) == flags.end() &&
-                    std::all_of(inputs.begin(), inputs.end(),
-                                [&flags](auto const &input)
-                                {
-                                    auto ptr = input->getSource().get();
-                                    return !ptr || flags.find(ptr) != flags.end();
-                                }))
+            auto op = ops[ready.top()];
+            ready.pop();
+            sorted.emplace_back(op);
+            for (auto const &output : op->getOutputs())
+                // targets hold one entry per input slot, like `pending`
+                for (auto const &target : output->getTargets())
                 {
-                    modified = true;
-                    sorted.emplace_back(op);
-                    flags.insert(op.get());
+                    auto it = pending.find(target.get());
+                    if (it != pending.end() && --it->second == 0)
+                        ready.push(opSlots.at(target.get()));
                 }
-            }
-            if (!modified)
-            {
-                return false;
-            }
         }
+        if (sorted.size() < ops.size())
+        {
+            return false;
+        }
+        plan.reset();
         this->ops = std::move(sorted);
+        for (size_t i = 0; i < ops.size(); ++i)
+            opSlots[ops[i].get()] = i;
         return this->sorted = true;
     }
 
     void GraphObj::optimize()
     {
-        // =================================== 作业 ===================================
-        // TODO: 设计一个算法来实现指定的图优化规则
-        // 图优化规则如下：
-        // 1. 去除冗余的算子（例如，两个相邻的算子都是 transpose 算子，且做的是相反的操作，可以将其全部删除）
-        // 2. 合并算子（例如，矩阵乘算子中含有属性transA、transB，如果其输入存在transpose，且对最后两个维度做交换，就可以将transpose融入到矩阵乘算子的属性中去）
-        // =================================== 作业 ===================================
-        if (!this->topo_sort()) {
-            std::cout << "!! topo_sort failed" << std::endl;
-            return;
+        // 1. 去除冗余的算子（例如，两个相邻的 transpose 算子做的是相反的操作）
+        // 2. 合并算子（例如，将交换最后两个维度的 transpose 融入矩阵乘的 transA、transB）
+        // 规则见 rewrite_rules.cc
+        IT_ASSERT(topo_sort(), "the graph has a cycle");
+        PassManager passes(defaultRewriteRules());
+        passes.run(*this);
+        if (passes.getCutOffRuns())
+            fprintf(stderr, "optimize: the rewrite rules did not reach a "
+                            "fixed point, the graph may be partly rewritten\n");
+        schedule();
+    }
+
+    ScheduleReport GraphObj::schedule(size_t exactLimit)
+    {
+        IT_ASSERT(topo_sort(), "the graph has a cycle");
+        ScheduleReport report;
+        report.peakBefore = report.peakAfter = peakLiveBytes(ops);
+        auto order = scheduleForMemory(ops, exactLimit);
+        if (auto peak = peakLiveBytes(order); peak < report.peakBefore)
+        {
+            plan.reset();
+            ops = std::move(order);
+            for (size_t i = 0; i < ops.size(); ++i)
+                opSlots[ops[i].get()] = i;
+            report.peakAfter = peak;
         }
-        
-        for (int i = 0; i < (int)ops.size(); i ++) {
-            auto now_op = ops[i];
-            // std::cout << "Processing Operation: " << now_op->toString() << std::endl;
-
-            switch (now_op->getOpType().underlying()) {
-            default: {
-                break;
+        return report;
+    }
+
+    void GraphObj::replaceInput(const Operator &op, const Tensor &oldInput,
+                                const Tensor &newInput)
+    {
+        IT_ASSERT(oldInput != newInput);
+        sorted = false;
+        plan.reset();
+        for (auto &pred : op->getPredecessors())
+        {
+            pred->removeSuccessors(op);
+            op->removePredecessors(pred);
+        }
+        op->replaceInput(oldInput, newInput);
+        oldInput->removeTarget(op);
+        // links are kept once per input slot, as addOperatorAndConnect does
+        for (auto &input : op->getInputs())
+        {
+            if (input == newInput)
+                newInput->addTarget(op);
+            if (auto pred = input->getSource())
+            {
+                pred->addSuccessors(op);
+                op->addPredecessors(pred);
             }
-            case OpType::Transpose : { // 去除冗余的算子
-                auto tensor0 = now_op->getInputs(0);
-                auto tensor1 = now_op->getOutputs()[0];
-                auto next_op = tensor1->getTargets()[0];
-                if (next_op && next_op->getOpType() == OpType::Transpose &&
-                    tensor1 == next_op->getInputs(0))
+        }
+        eraseIfDead(oldInput);
+    }
+
+    void GraphObj::replaceAllUses(const Tensor &oldTensor,
+                                  const Tensor &newTensor)
+    {
+        auto targets = oldTensor->getTargets();
+        IT_ASSERT(!targets.empty(), "cannot replace a graph output");
+        // the last replaceInput() erases oldTensor and its producer
+        for (auto &op : targets)
+            replaceInput(op, oldTensor, newTensor);
+    }
+
+    void GraphObj::replaceOutput(const Operator &op, const Tensor &oldOutput,
+                                 const Tensor &newOutput)
+    {
+        IT_ASSERT(oldOutput->getSource() == op);
+        IT_ASSERT(!newOutput->getSource(), "the new output is already written");
+        sorted = false;
+        plan.reset();
+        op->replaceOutput(oldOutput, newOutput);
+        oldOutput->setSource(nullptr);
+        newOutput->setSource(op);
+        // a consumer of oldOutput may still read another output of op
+        for (auto &succ : oldOutput->getTargets())
+        {
+            succ->removePredecessors(op);
+            op->removeSuccessors(succ);
+            for (auto &input : succ->getInputs())
+                if (input->getSource() == op)
                 {
-                    auto tensor3 = next_op->getOutputs()[0];
-
-                    // tensor3->setSource(nullptr);
-                    tensor0->removeTarget(now_op);  // important
-                    for (auto &targetOp  : tensor3->getTargets()) {
-                        targetOp->replaceInput(tensor3, tensor0);
-                        tensor0->addTarget(targetOp);
-                        targetOp->removePredecessors(next_op);
-                    }
-                    for (auto pred : now_op->getPredecessors()) {
-                        pred->removeSuccessors(now_op);
-                    }
-
-                    removeTensor(tensor1);
-                    removeTensor(tensor3);
-                    // ops.erase(ops.begin() + i, ops.begin() + i + 2);
-                    removeOperator(now_op);
-                    removeOperator(next_op);
-                    i --;
-                }
-                break;
-            }
-			case OpType::MatMul: { // 合并算子
-                auto matmulOp = as<MatmulObj>(now_op);
-                // bool optimized = false; // 用于标记当前 MatMul 是否优化过
-                for (int cc = 0; cc < 2; cc ++) {
-                    auto matmulInput = matmulOp->getInputs()[cc];
-
-                    // 检查输入是否为 Transpose
-                    if (matmulInput) { 
-                        auto inputOp = matmulInput->getSource();
-                        if (inputOp && inputOp->getOpType() == OpType::Transpose) {
-                            auto transposeOp = as<TransposeObj>(inputOp);
-                            std::cout << "-current input " << (cc+1) << " is " << matmulInput->toString() << std::endl;
-                            std::cout << "-current input " << (cc+1) << " is a Transpose operation: " << transposeOp->toString() << std::endl;
-
-                            // 判断 Transpose 是否对最后两个维度的交换
-                            auto permute = transposeOp->getPermute();
-                            if (permute.size() >= 2 &&
-                                permute[permute.size() - 2] == static_cast<int>(permute.size() - 1) &&
-                                permute[permute.size() - 1] == static_cast<int>(permute.size() - 2)) 
-                            {
-                                std::cout << "Found Transpose on Input that swaps the last two dimensions." << std::endl;
-
-                                // 更新 MatMul 的 transA/B 属性
-                                if (cc == 0)
-                                    matmulOp->setTransA(!matmulOp->getTransA());
-                                else
-                                    matmulOp->setTransB(!matmulOp->getTransB());
-
-                                // if (!transposeOp->getOutputs().empty()) {
-                                // std::cout << "Changing MatMul Input from Transpose->Input to Transpose's Source." << std::endl;
-                                auto transposeOutput = transposeOp->getOutputs()[0]; // 获取 Transpose 的输出张量
-                                auto transposeInput = transposeOp->getInputs(0); // 获取 Transpose 的输入张量
-
-                                transposeInput->addTarget(matmulOp);
-
-                                // 删除 Transpose 输出张量的来源连接
-                                transposeOutput->setSource(nullptr);
-
-                                // 将 Transpose 从其输入张量的 targets 列表中移除
-                                matmulInput->removeTarget(transposeOp);
-                                matmulOp->replaceInput(matmulInput, transposeInput);
-
-                                removeOperator(transposeOp);
-                                removeTensor(matmulInput);
-
-                                this->print();
-                            }
-                        }
-                    }
+                    succ->addPredecessors(op);
+                    op->addSuccessors(succ);
                 }
-                break;
-            }
-            }
+        }
+        for (auto &succ : newOutput->getTargets())
+        {
+            succ->addPredecessors(op);
+            op->addSuccessors(succ);
         }
     }
 
-    Tensor GraphObj::getTensor(int fuid) const
+    void GraphObj::eraseOperator(const Operator &op)
     {
-        for (auto tensor : tensors)
+        sorted = false;
+        plan.reset();
+        for (auto &output : op->getOutputs())
         {
-            if (tensor->getFuid() == fuid)
-            {
-                return tensor;
-            }
+            IT_ASSERT(output->getTargets().empty(),
+                      "erasing an operator whose output is still used");
+            removeTensor(output);
         }
-        return nullptr;
+        for (auto &pred : op->getPredecessors())
+            pred->removeSuccessors(op);
+        auto inputs = op->getInputs();
+        for (auto &input : inputs)
+            input->removeTarget(op);
+        removeOperator(op);
+        for (auto &input : inputs)
+            eraseIfDead(input);
+    }
+
+    void GraphObj::eraseIfDead(const Tensor &tensor)
+    {
+        if (!tensor->getTargets().empty() || !hasTensor(tensor))
+            return;
+        auto source = tensor->getSource();
+        if (!source)
+        {
+            // a graph input nothing reads any more
+            removeTensor(tensor);
+            return;
+        }
+        auto outputs = source->getOutputs();
+        if (std::all_of(outputs.begin(), outputs.end(), [](const Tensor &t)
+                        { return t->getTargets().empty(); }))
+            eraseOperator(source);
+    }
+
+    Tensor GraphObj::getTensor(int fuid) const
+    {
+        auto it = tensorsByFuid.find(fuid);
+        return it == tensorsByFuid.end() ? nullptr : it->second;
     }
 
     void GraphObj::shape_infer()
     {
+        plan.reset();
+        compact();
         for (auto &op : ops)
         {
             auto ans = op->inferShape();
@@ -230,49 +321,220 @@ namespace infini
             for (int i = 0; i < (int)ans.value().size(); ++i)
             {
                 auto newShape = ans.value()[i];
-                auto oldShape = oldOutputs[i]->getDims();
-                auto fuid = oldOutputs[i]->getFuid();
-                if (newShape != oldShape)
-                {
-                    auto tensor = this->getTensor(fuid);
-                    tensor->setShape(newShape);
-                }
+                if (newShape != oldOutputs[i]->getDims())
+                    oldOutputs[i]->setShape(newShape);
             }
         }
     }
 
+    // Whether the kernel of `op` computes each output element from the
+    // input elements at the same position only, so that its output may
+    // share the block of an input of the same shape.
+    static bool canRunInPlace(const Operator &op)
+    {
+        switch (op->getOpType().underlying())
+        {
+        case OpType::Add:
+        case OpType::Sub:
+        case OpType::Mul:
+        case OpType::Div:
+        case OpType::Relu:
+        case OpType::Clip:
+        case OpType::FusedElementwise:
+            return true;
+        default:
+            // MatMul in particular accumulates into its output before the
+            // epilogue reads the residual
+            return false;
+        }
+    }
+
+    // Whether the kernel of `op` reads its inputs through their strides, so
+    // that they may be views of another tensor's block.
+    static bool readsStridedInputs(const Operator &op)
+    {
+        switch (op->getOpType().underlying())
+        {
+        case OpType::Add:
+        case OpType::Sub:
+        case OpType::Mul:
+        case OpType::Div:
+        case OpType::FusedElementwise:
+        case OpType::Transpose:
+            return true;
+        default:
+            return false;
+        }
+    }
+
     void GraphObj::dataMalloc()
     {
-        // topological sorting first
+        plan.reset();
+        // topological sorting first, which also compacts the graph
         IT_ASSERT(topo_sort() == true);
 
-        // =================================== 作业 ===================================
-        // TODO：利用 allocator 给计算图分配内存
-        // HINT: 获取分配好的内存指针后，可以调用 tensor 的 setDataBlob 函数给 tensor 绑定内存
-        // =================================== 作业 ===================================
-        
-        std::vector<size_t> tensor_offset_vec = std::vector<size_t>(tensors.size());
-        for (size_t i = 0; i < tensors.size(); i++)
+        // Graph inputs and outputs stay pinned for the whole run, while every
+        // intermediate tensor is handed back to the allocator as soon as its
+        // last consumer has been scheduled.
+        std::unordered_map<TensorObj *, size_t> lastUse;
+        for (size_t i = 0; i < ops.size(); ++i)
+            for (auto &input : ops[i]->getInputs())
+                lastUse[input.get()] = i;
+        auto isPinned = [](const TensorObj *tensor)
         {
-            auto offset = allocator.alloc(tensors[i]->getBytes());
-            tensor_offset_vec[i] = offset;
+            return !tensor->getSource() || tensor->getTargets().empty();
+        };
+
+        // A Transpose whose consumers all read strided inputs moves no data:
+        // its output is a view of its input's block, which then lives until
+        // the last reader of any of its views.
+        std::unordered_map<TensorObj *, TensorObj *> viewOf;
+        for (auto &op : ops)
+        {
+            if (op->getOpType() != OpType::Transpose)
+                continue;
+            auto targets = op->getOutput()->getTargets();
+            if (!targets.empty() &&
+                std::all_of(targets.begin(), targets.end(), readsStridedInputs))
+                viewOf[op->getOutput().get()] = op->getInputs(0).get();
         }
-        auto start_ptr= allocator.getPtr();
-        for (size_t i = 0; i < tensors.size(); i++)
+        // The tensor whose block `tensor` is read from.
+        auto viewed = [&](TensorObj *tensor)
         {
-            auto offset = tensor_offset_vec[i];
-            // 指针加上偏移量
-            void *ptr = reinterpret_cast<char *>(start_ptr) + offset;
-            // new blob
-            tensors[i]->setDataBlob(make_ref<BlobObj>(runtime, ptr));
+            for (auto it = viewOf.find(tensor); it != viewOf.end();
+                 it = viewOf.find(tensor))
+                tensor = it->second;
+            return tensor;
+        };
+        std::unordered_set<TensorObj *> hasViews;
+        for (auto &[view, input] : viewOf)
+        {
+            auto root = viewed(view);
+            hasViews.insert(root);
+            lastUse[root] = std::max(lastUse[root], lastUse[view]);
+        }
+
+        // A concat input read by nothing else is computed straight into its
+        // slice of the concat output, provided the slices are contiguous:
+        // every dim before the concat axis is 1. The concat kernel then has
+        // nothing left to copy for it.
+        std::unordered_map<TensorObj *, std::pair<TensorObj *, size_t>> slices;
+        for (auto &op : ops)
+        {
+            if (op->getOpType() != OpType::Concat)
+                continue;
+            auto output = op->getOutput();
+            auto dims = output->getDims();
+            auto dim = as<ConcatObj>(op)->getDim();
+            if (std::any_of(dims.begin(), dims.begin() + dim, [](int d)
+                            { return d != 1; }))
+                continue;
+            size_t offset = 0;
+            for (auto &input : op->getInputs())
+            {
+                if (input->getSource() && input->getTargets().size() == 1)
+                    slices[input.get()] = {output.get(), offset};
+                offset += input->getBytes();
+            }
         }
+        // The tensor whose block holds `tensor`, following nested concats,
+        // and the offset of `tensor` in it.
+        auto placement = [&](TensorObj *tensor)
+        {
+            size_t offset = 0;
+            for (auto it = slices.find(tensor); it != slices.end();
+                 it = slices.find(tensor))
+            {
+                offset += it->second.second;
+                tensor = it->second.first;
+            }
+            return std::make_pair(tensor, offset);
+        };
 
-        allocator.info();
+        // constants keep the storage they own
+        std::unordered_map<TensorObj *, size_t> offsets;
+        for (auto &tensor : tensors)
+            if (!tensor->getSource() && !tensor->isConstant())
+                offsets[tensor.get()] = allocator.alloc(tensor->getBytes());
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            // an input dying here hands its block over to the output
+            if (canRunInPlace(ops[i]) &&
+                !offsets.count(ops[i]->getOutput().get()) &&
+                !slices.count(ops[i]->getOutput().get()))
+            {
+                auto output = ops[i]->getOutput();
+                for (auto &input : ops[i]->getInputs())
+                {
+                    auto it = lastUse.find(input.get());
+                    if (it == lastUse.end() || it->second != i ||
+                        isPinned(input.get()) || slices.count(input.get()) ||
+                        viewOf.count(input.get()) ||
+                        hasViews.count(input.get()) ||
+                        input->getDims() != output->getDims() ||
+                        !(input->getDType() == output->getDType()))
+                        continue;
+                    offsets[output.get()] = offsets[input.get()];
+                    lastUse.erase(it);
+                    break;
+                }
+            }
+            for (auto &output : ops[i]->getOutputs())
+            {
+                // the block of a concat output is taken as soon as the first
+                // of its slices is computed
+                if (offsets.count(output.get()) || viewOf.count(output.get()))
+                    continue;
+                auto [block, offset] = placement(output.get());
+                if (!offsets.count(block))
+                    offsets[block] = allocator.alloc(block->getBytes());
+                offsets[output.get()] = offsets[block] + offset;
+            }
+            for (auto &input : ops[i]->getInputs())
+            {
+                // reading a view keeps the block it looks into alive
+                auto tensor = viewed(input.get());
+                auto it = lastUse.find(tensor);
+                // a slice goes with the block of its concat output
+                if (it == lastUse.end() || it->second != i ||
+                    isPinned(tensor) || slices.count(tensor))
+                    continue;
+                allocator.free(offsets[tensor], tensor->getBytes());
+                // an op may consume the same tensor twice
+                lastUse.erase(it);
+            }
+        }
+
+        auto start_ptr = allocator.getPtr();
+        for (auto &tensor : tensors)
+        {
+            if (tensor->isConstant() || viewOf.count(tensor.get()))
+                continue;
+            // 指针加上偏移量
+            void *ptr = reinterpret_cast<char *>(start_ptr) + offsets[tensor.get()];
+            tensor->setDataBlob(make_ref<BlobObj>(runtime, ptr));
+        }
+        // in topological order, so that a view of a view sees its input's
+        // final layout
+        for (auto &op : ops)
+        {
+            if (op->getOpType() != OpType::Transpose ||
+                !viewOf.count(op->getOutput().get()))
+                continue;
+            auto input = op->getInputs(0);
+            auto perm = as<TransposeObj>(op)->getPermute();
+            auto inStrides = input->getStrides();
+            Shape strides(perm.size());
+            for (size_t d = 0; d < perm.size(); ++d)
+                strides[d] = inStrides[perm[d]];
+            op->getOutput()->setView(input->getDataBlob(), strides,
+                                     input->getOffset());
+        }
     }
 
     Tensor GraphObj::addTensor(Shape dim, DataType dtype)
     {
-        return tensors.emplace_back(make_ref<TensorObj>(dim, dtype, runtime));
+        return addTensor(make_ref<TensorObj>(dim, dtype, runtime));
     }
 
     Tensor GraphObj::addTensor(const Tensor &tensor)
@@ -281,6 +543,8 @@ namespace infini
                   std::string("Tensor runtime mismatch: cannot add a tenosr in ") +
                       tensor->getRuntime()->toString() + " to " +
                       runtime->toString());
+        tensorSlots[tensor.get()] = tensors.size();
+        tensorsByFuid[tensor->getFuid()] = tensor;
         tensors.emplace_back(tensor);
         return tensor;
     }
@@ -292,52 +556,58 @@ namespace infini
         return tensors;
     }
 
+    const ExecutionPlan &GraphObj::getPlan()
+    {
+        if (!plan)
+        {
+            IT_ASSERT(topo_sort() == true);
+            plan = make_ref<ExecutionPlan>(ops, runtime.get());
+        }
+        return *plan;
+    }
+
     // tensor's "source" and "target" must be in "ops".
     // tensor has no "source" and no "target" must not exist.
     // "inputs" or "outputs" of operators must be in "tensors"
     // "predecessors" and "successors" of an operator of "ops" must be in "ops".
     bool GraphObj::checkValid() const
     {
+        compact();
+        IT_ASSERT(tensorSlots.size() == tensors.size(),
+                  "a tensor is in the graph twice");
         for (auto tensor : tensors)
         {
             IT_ASSERT(!(tensor->getTargets().size() == 0 &&
                         nullptr == tensor->getSource()));
             for (auto op : tensor->getTargets())
             {
-                IT_ASSERT(std::find(ops.begin(), ops.end(), op) != ops.end());
+                IT_ASSERT(hasOperator(op));
             }
             auto op = tensor->getSource();
-            IT_ASSERT(!(op && std::find(ops.begin(), ops.end(), op) == ops.end()));
+            IT_ASSERT(!(op && !hasOperator(op)));
+            // check whether two tensors with the same FUID exist
+            IT_ASSERT(getTensor(tensor->getFuid()) == tensor,
+                      std::to_string(tensor->getFuid()));
         }
         for (auto op : ops)
         {
             for (auto tensor : op->getInputs())
             {
-                IT_ASSERT(std::find(tensors.begin(), tensors.end(), tensor) !=
-                          tensors.end());
+                IT_ASSERT(hasTensor(tensor));
             }
             for (auto tensor : op->getOutputs())
             {
-                IT_ASSERT(std::find(tensors.begin(), tensors.end(), tensor) !=
-                          tensors.end());
+                IT_ASSERT(hasTensor(tensor));
             }
             for (auto pre : op->getPredecessors())
             {
-                IT_ASSERT(std::find(ops.begin(), ops.end(), pre) != ops.end());
+                IT_ASSERT(hasOperator(pre));
             }
             for (auto suc : op->getSuccessors())
             {
-                IT_ASSERT(std::find(ops.begin(), ops.end(), suc) != ops.end());
+                IT_ASSERT(hasOperator(suc));
             }
         }
-        std::set<UidBaseType> s;
-        // check whether two tensors with the same FUID exist
-        for (auto tensor : tensors)
-        {
-            int cnt = s.count(tensor->getFuid());
-            IT_ASSERT(cnt == 0, std::to_string(tensor->getFuid()));
-            s.insert(tensor->getFuid());
-        }
         return true;
     }
 
@@ -21,6 +21,7 @@ namespace infini
             CASE(Transpose);
             CASE(Concat);
             CASE(MatMul);
+            CASE(FusedElementwise);
 
         default:
             return "Unknown";
@@ -40,6 +40,13 @@ namespace infini
         }
     }
 
+    void OperatorObj::replaceOutput(Tensor t1, Tensor t2)
+    {
+        for (auto &output : outputs)
+            if (output == t1)
+                output = t2;
+    }
+
     bool OperatorObj::checkValid(GraphObj *graph)
     {
         auto optShapes = inferShape();
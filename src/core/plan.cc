@@ -0,0 +1,138 @@
+#include "core/plan.h"
+#include "core/profiler.h"
+#include "core/runtime.h"
+#include "core/tensor.h"
+#include <map>
+#include <unordered_map>
+
+namespace infini
+{
+
+    ExecutionPlan::ExecutionPlan(const OpVec &ops, const RuntimeObj *runtime)
+    {
+        const auto &kernelRegistry = KernelRegistry::getInstance();
+        entries.reserve(ops.size());
+        for (auto &op : ops)
+        {
+            auto kernelAttrs =
+                KernelAttrs{runtime->getDevice(), op->getOpType().underlying()};
+            Kernel *kernel = kernelRegistry.getKernel(kernelAttrs);
+            const string &name =
+                std::get<1>(kernelRegistry.getKernelItem(kernelAttrs));
+            entries.push_back(
+                {op, kernel, name, kernel->compile(op, runtime), {}, 0});
+        }
+    }
+
+    const vector<ExecutionPlan::Entry> &
+    ExecutionPlan::getEntriesWithDependencies() const
+    {
+        std::call_once(dependenciesBuilt, [this]
+                       { buildDependencies(); });
+        return entries;
+    }
+
+    void ExecutionPlan::buildDependencies() const
+    {
+        const size_t n = entries.size();
+        std::unordered_map<OperatorObj *, size_t> index;
+        for (size_t i = 0; i < n; ++i)
+            index[entries[i].op.get()] = i;
+
+        vector<vector<size_t>> successors(n);
+        for (size_t i = 0; i < n; ++i)
+            for (auto &pred : entries[i].op->getPredecessors())
+                successors.at(index.at(pred.get())).push_back(i);
+
+        // Every tensor produced in the plan occupies a block: a byte range.
+        // When a later block overlaps an earlier one, it is written into
+        // memory the earlier one has released, so its producer must wait for
+        // the earlier producer and all its readers. Only the last writer of
+        // each address matters: older writers are ordered before it already.
+        // `segments` maps the begin of disjoint ranges to their end and to
+        // the block that last wrote them.
+        struct Segment
+        {
+            uintptr_t end;
+            size_t block;
+        };
+        std::map<uintptr_t, Segment> segments;
+        vector<size_t> producers;
+        vector<OpVec> readers;
+        auto overwrite = [&](size_t later, uintptr_t begin, uintptr_t end)
+        {
+            size_t producer = producers[later];
+            auto it = segments.upper_bound(begin);
+            if (it != segments.begin() && std::prev(it)->second.end > begin)
+                --it;
+            while (it != segments.end() && it->first < end)
+            {
+                auto [segBegin, seg] = *it;
+                if (producers[seg.block] != producer)
+                    successors[producers[seg.block]].push_back(producer);
+                for (auto &reader : readers[seg.block])
+                {
+                    size_t r = index.at(reader.get());
+                    if (r == producer)
+                        continue;
+                    // dataMalloc() frees a block only after its last reader
+                    IT_ASSERT(r < producer);
+                    successors[r].push_back(producer);
+                }
+                // the parts outside [begin, end) keep their writer
+                it = segments.erase(it);
+                if (segBegin < begin)
+                    segments[segBegin] = {begin, seg.block};
+                if (seg.end > end)
+                    segments[end] = {seg.end, seg.block};
+            }
+            segments[begin] = {end, later};
+        };
+        // A view shares the blob of the tensor it looks into and occupies
+        // no range of its own: its readers read that tensor's block.
+        std::unordered_map<BlobObj *, size_t> blockOfBlob;
+        for (size_t i = 0; i < n; ++i)
+            for (auto &output : entries[i].op->getOutputs())
+            {
+                auto targets = output->getTargets();
+                auto it = blockOfBlob.find(output->getDataBlob().get());
+                if (it != blockOfBlob.end())
+                {
+                    auto &blockReaders = readers[it->second];
+                    blockReaders.insert(blockReaders.end(), targets.begin(),
+                                        targets.end());
+                    continue;
+                }
+                if (output->getBytes() == 0)
+                    continue;
+                auto begin = reinterpret_cast<uintptr_t>(
+                    output->getRawDataPtr<void *>());
+                size_t block = producers.size();
+                blockOfBlob[output->getDataBlob().get()] = block;
+                producers.push_back(i);
+                readers.push_back(targets);
+                overwrite(block, begin, begin + output->getBytes());
+            }
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            auto &succ = successors[i];
+            std::sort(succ.begin(), succ.end());
+            succ.erase(std::unique(succ.begin(), succ.end()), succ.end());
+            for (size_t s : succ)
+                ++entries[s].numPredecessors;
+            entries[i].successors = std::move(succ);
+        }
+    }
+
+    void ExecutionPlan::run(Profiler *profiler) const
+    {
+        if (profiler)
+            for (auto &entry : entries)
+                profiler->time(entry, 0);
+        else
+            for (auto &entry : entries)
+                entry.routine();
+    }
+
+} // namespace infini
@@ -0,0 +1,205 @@
+#include "core/profiler.h"
+#include "operators/fused_element_wise.h"
+#include "operators/matmul.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace infini
+{
+
+    static string escapeJson(const string &s)
+    {
+        string out;
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    static string shapesToString(const vector<Shape> &shapes)
+    {
+        string out;
+        for (size_t i = 0; i < shapes.size(); ++i)
+            out += (i ? "," : "") + vecToString(shapes[i]);
+        return out;
+    }
+
+    static vector<Shape> shapesOf(const TensorVec &tensors)
+    {
+        vector<Shape> shapes;
+        for (auto &tensor : tensors)
+            shapes.push_back(tensor->getDims());
+        return shapes;
+    }
+
+    double Profiler::estimateFlops(const Operator &op)
+    {
+        switch (op->getOpType().underlying())
+        {
+        case OpType::MatMul:
+        {
+            auto matmul = as<MatmulObj>(op);
+            // a multiply and an add per K for every output element, and one
+            // operation per fused epilogue step
+            double size = matmul->getOutput()->size();
+            int epilogue = (matmul->getBias() != nullptr) +
+                           (matmul->getResidual() != nullptr) +
+                           (matmul->getMin() || matmul->getMax());
+            return size * (2.0 * matmul->getK() + epilogue);
+        }
+        case OpType::Add:
+        case OpType::Sub:
+        case OpType::Mul:
+        case OpType::Div:
+        case OpType::Relu:
+        case OpType::Clip:
+            return op->getOutput()->size();
+        case OpType::FusedElementwise:
+            // one operation per program step and output element
+            return double(op->getOutput()->size()) *
+                   as<FusedElementwiseObj>(op)->getProgram().size();
+        default:
+            // data movement only
+            return 0;
+        }
+    }
+
+    double Profiler::estimateBytes(const Operator &op)
+    {
+        double bytes = 0;
+        for (auto &input : op->getInputs())
+            bytes += input->getBytes();
+        for (auto &output : op->getOutputs())
+            bytes += output->getBytes();
+        return bytes;
+    }
+
+    void Profiler::record(const ExecutionPlan::Entry &entry,
+                          Clock::time_point begin, Clock::time_point end,
+                          int thread)
+    {
+        using Micros = std::chrono::duration<double, std::micro>;
+        const auto &op = entry.op;
+        Record r{entry.kernelName,
+                 op->getOpType(),
+                 op->getGuid(),
+                 shapesOf(op->getInputs()),
+                 shapesOf(op->getOutputs()),
+                 0,
+                 Micros(end - begin).count(),
+                 thread,
+                 estimateFlops(op),
+                 estimateBytes(op)};
+        std::lock_guard<std::mutex> lock(mutex);
+        r.start = Micros(begin - origin).count();
+        records.push_back(std::move(r));
+    }
+
+    void Profiler::time(const ExecutionPlan::Entry &entry, int thread)
+    {
+        auto begin = Clock::now();
+        entry.routine();
+        record(entry, begin, Clock::now(), thread);
+    }
+
+    vector<Profiler::Record> Profiler::getRecords() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return records;
+    }
+
+    void Profiler::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        records.clear();
+        origin = Clock::now();
+    }
+
+    string Profiler::summary() const
+    {
+        struct Row
+        {
+            string kernel;
+            size_t calls = 0;
+            double time = 0, flops = 0, bytes = 0;
+        };
+        vector<Row> rows;
+        double total = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::map<string, size_t> index;
+            for (auto &r : records)
+            {
+                auto [it, added] = index.emplace(r.kernel, rows.size());
+                if (added)
+                    rows.push_back({r.kernel});
+                Row &row = rows[it->second];
+                ++row.calls;
+                row.time += r.duration;
+                row.flops += r.flops;
+                row.bytes += r.bytes;
+                total += r.duration;
+            }
+        }
+        std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b)
+                  { return a.time > b.time; });
+
+        std::ostringstream os;
+        os << std::left << std::setw(24) << "kernel" << std::right
+           << std::setw(8) << "calls" << std::setw(12) << "total(ms)"
+           << std::setw(12) << "mean(us)" << std::setw(8) << "%"
+           << std::setw(10) << "GFLOP/s" << std::setw(10) << "GB/s" << "\n";
+        os << std::fixed;
+        for (auto &row : rows)
+        {
+            // flops per microsecond are 1e-3 GFLOP/s, the same for bytes
+            double micros = row.time > 0 ? row.time : 1;
+            os << std::left << std::setw(24) << row.kernel << std::right
+               << std::setw(8) << row.calls << std::setprecision(3)
+               << std::setw(12) << row.time / 1e3 << std::setw(12)
+               << row.time / row.calls << std::setprecision(1) << std::setw(8)
+               << (total > 0 ? 100 * row.time / total : 0)
+               << std::setprecision(2) << std::setw(10)
+               << row.flops / micros / 1e3 << std::setw(10)
+               << row.bytes / micros / 1e3 << "\n";
+        }
+        os << std::left << std::setw(24) << "total" << std::right
+           << std::setw(20) << std::setprecision(3) << total / 1e3 << "\n";
+        return os.str();
+    }
+
+    string Profiler::toChromeTrace() const
+    {
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(3);
+        os << "{\"traceEvents\":[";
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            const Record &r = records[i];
+            os << (i ? ",\n" : "\n") << "{\"name\":\""
+               << escapeJson(r.opType.toString()) << "\",\"cat\":\"op\""
+               << ",\"ph\":\"X\",\"ts\":" << r.start << ",\"dur\":"
+               << r.duration << ",\"pid\":0,\"tid\":" << r.thread
+               << ",\"args\":{\"kernel\":\"" << escapeJson(r.kernel)
+               << "\",\"guid\":" << r.guid << ",\"inputs\":\""
+               << shapesToString(r.inputs) << "\",\"outputs\":\""
+               << shapesToString(r.outputs) << "\",\"flops\":" << r.flops
+               << ",\"bytes\":" << r.bytes << "}}";
+        }
+        os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        return os.str();
+    }
+
+    void Profiler::dumpChromeTrace(const string &path) const
+    {
+        std::ofstream file(path);
+        IT_ASSERT(file, "cannot open " + path);
+        file << toChromeTrace();
+    }
+
+} // namespace infini
@@ -0,0 +1,74 @@
+#include "core/rewrite.h"
+#include <iomanip>
+
+namespace infini
+{
+
+    PassManager::PassManager(vector<RewriteRule> rules)
+    {
+        for (auto &rule : rules)
+            add(std::move(rule));
+    }
+
+    void PassManager::add(RewriteRule rule)
+    {
+        IT_ASSERT(rule.match && rule.rewrite, "incomplete rule " + rule.name);
+        rules.push_back(std::move(rule));
+        stats.emplace_back();
+    }
+
+    size_t PassManager::run(GraphObj &graph, size_t maxRounds)
+    {
+        size_t total = 0;
+        bool converged = false;
+        for (size_t round = 0; round < maxRounds && !converged; ++round)
+        {
+            IT_ASSERT(graph.topo_sort(), "the graph has a cycle");
+            // a rewrite may erase operators further down the snapshot
+            auto snapshot = graph.getOperators();
+
+            size_t applied = 0;
+            for (auto &op : snapshot)
+            {
+                if (!graph.hasOperator(op))
+                    continue;
+                for (size_t i = 0; i < rules.size(); ++i)
+                {
+                    auto &rule = rules[i];
+                    if (rule.root != OpType::Unknown &&
+                        rule.root != op->getOpType())
+                        continue;
+                    ++stats[i].attempts;
+                    if (!rule.match(op))
+                        continue;
+                    rule.rewrite(graph, op);
+                    ++stats[i].applied;
+                    ++applied;
+                    break;
+                }
+            }
+            total += applied;
+            converged = applied == 0;
+        }
+        if (!converged)
+            ++cutOffRuns;
+        IT_ASSERT(graph.checkValid());
+        return total;
+    }
+
+    string PassManager::statsToString() const
+    {
+        std::ostringstream oss;
+        oss << std::left << std::setw(40) << "rule" << std::right
+            << std::setw(10) << "attempts" << std::setw(10) << "applied"
+            << "\n";
+        for (size_t i = 0; i < rules.size(); ++i)
+            oss << std::left << std::setw(40) << rules[i].name << std::right
+                << std::setw(10) << stats[i].attempts << std::setw(10)
+                << stats[i].applied << "\n";
+        if (cutOffRuns)
+            oss << cutOffRuns << " run(s) stopped before a fixed point\n";
+        return oss.str();
+    }
+
+} // namespace infini
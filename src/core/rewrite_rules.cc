@@ -0,0 +1,549 @@
+#include "core/kernel.h"
+#include "core/rewrite.h"
+#include "operators/concat.h"
+#include "operators/fused_element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+namespace infini
+{
+
+    // The Transpose computing `tensor`, if any.
+    static Ref<TransposeObj> producingTranspose(const Tensor &tensor)
+    {
+        auto source = tensor->getSource();
+        if (!source || source->getOpType() != OpType::Transpose)
+            return nullptr;
+        return as<TransposeObj>(source);
+    }
+
+    static bool isIdentity(const vector<int> &permute)
+    {
+        for (size_t i = 0; i < permute.size(); ++i)
+            if (permute[i] != int(i))
+                return false;
+        return true;
+    }
+
+    // Transpose(x, p) == x when p is the identity.
+    static RewriteRule removeIdentityTranspose()
+    {
+        RewriteRule rule;
+        rule.name = "remove-identity-transpose";
+        rule.root = OpType::Transpose;
+        rule.match = [](const Operator &op)
+        {
+            // the output of a graph has no consumer to redirect
+            return isIdentity(as<TransposeObj>(op)->getPermute()) &&
+                   !op->getOutput()->getTargets().empty();
+        };
+        rule.rewrite = [](GraphObj &graph, const Operator &op)
+        { graph.replaceAllUses(op->getOutput(), op->getInputs(0)); };
+        return rule;
+    }
+
+    // Transpose(Transpose(x, p1), p2) == Transpose(x, p) with
+    // p[i] = p1[p2[i]], which is x itself when p is the identity.
+    static RewriteRule composeTransposes()
+    {
+        RewriteRule rule;
+        rule.name = "compose-transposes";
+        rule.root = OpType::Transpose;
+        rule.match = [](const Operator &op)
+        { return producingTranspose(op->getInputs(0)) != nullptr; };
+        rule.rewrite = [](GraphObj &graph, const Operator &op)
+        {
+            auto second = as<TransposeObj>(op);
+            auto first = producingTranspose(op->getInputs(0));
+            auto p1 = first->getPermute(), p2 = second->getPermute();
+            vector<int> permute(p2.size());
+            for (size_t i = 0; i < p2.size(); ++i)
+                permute[i] = p1[p2[i]];
+            auto x = first->getInputs(0);
+            if (isIdentity(permute) && !op->getOutput()->getTargets().empty())
+                graph.replaceAllUses(op->getOutput(), x);
+            else
+            {
+                // the first transpose goes away unless something else reads
+                // its output
+                second->setPermute(permute);
+                graph.replaceInput(op, op->getInputs(0), x);
+            }
+        };
+        return rule;
+    }
+
+    // Whether `transpose` swaps the last two dimensions and nothing else.
+    static bool swapsLastTwoDims(const Ref<TransposeObj> &transpose)
+    {
+        if (!transpose)
+            return false;
+        auto permute = transpose->getPermute();
+        int rank = permute.size();
+        if (rank < 2)
+            return false;
+        for (int i = 0; i < rank - 2; ++i)
+            if (permute[i] != i)
+                return false;
+        return permute[rank - 2] == rank - 1 && permute[rank - 1] == rank - 2;
+    }
+
+    // MatMul(Transpose(a), b) == MatMul(a, b) with transA flipped, when the
+    // transpose swaps the last two dimensions; likewise for b.
+    static RewriteRule foldTransposeIntoMatmul()
+    {
+        RewriteRule rule;
+        rule.name = "fold-transpose-into-matmul";
+        rule.root = OpType::MatMul;
+        rule.match = [](const Operator &op)
+        {
+            return swapsLastTwoDims(producingTranspose(op->getInputs(0))) ||
+                   swapsLastTwoDims(producingTranspose(op->getInputs(1)));
+        };
+        rule.rewrite = [](GraphObj &graph, const Operator &op)
+        {
+            auto matmul = as<MatmulObj>(op);
+            auto a = op->getInputs(0), b = op->getInputs(1);
+            auto ta = producingTranspose(a), tb = producingTranspose(b);
+            bool foldA = swapsLastTwoDims(ta), foldB = swapsLastTwoDims(tb);
+            if (foldA)
+                matmul->setTransA(!matmul->getTransA());
+            if (foldB)
+                matmul->setTransB(!matmul->getTransB());
+            if (foldA)
+                graph.replaceInput(op, a, ta->getInputs(0));
+            // replaceInput() already redirected b if it is the same tensor
+            if (foldB && b != a)
+                graph.replaceInput(op, b, tb->getInputs(0));
+        };
+        return rule;
+    }
+
+    // Whether `bias` holds one value per column of `output`, broadcast
+    // along every other dimension.
+    static bool isColumnBias(const Tensor &bias, const Tensor &output)
+    {
+        auto dims = bias->getDims();
+        return dims.size() <= output->getRank() &&
+               dims.back() == output->getDims().back() &&
+               bias->size() == size_t(dims.back());
+    }
+
+    // Whether fuse-matmul-epilogue can absorb the consumer of `op`.
+    static bool hasFusibleEpilogue(const Operator &op)
+    {
+        if (op->getOpType() != OpType::MatMul)
+            return false;
+        auto matmul = as<MatmulObj>(op);
+        auto output = op->getOutput();
+        auto targets = output->getTargets();
+        if (targets.size() != 1)
+            return false;
+        auto next = targets[0];
+        // the clamp comes last, nothing can be fused after it
+        bool clamped = matmul->getMin() || matmul->getMax();
+        switch (next->getOpType().underlying())
+        {
+        case OpType::Relu:
+        case OpType::Clip:
+            return !clamped;
+        case OpType::Add:
+        {
+            auto other = next->getInputs(0) == output ? next->getInputs(1)
+                                                      : next->getInputs(0);
+            if (clamped || other == output ||
+                !(other->getDType() == output->getDType()))
+                return false;
+            return (!matmul->getBias() && isColumnBias(other, output)) ||
+                   (!matmul->getResidual() &&
+                    other->getDims() == output->getDims());
+        }
+        default:
+            return false;
+        }
+    }
+
+    // MatMul followed by a bias Add, a residual Add, then Relu or Clip,
+    // becomes one MatMul applying them as its output tiles are stored. Each
+    // rewrite absorbs the single consumer of the matmul's output, so a chain
+    // is absorbed one op per round.
+    static RewriteRule fuseMatmulEpilogue()
+    {
+        RewriteRule rule;
+        rule.name = "fuse-matmul-epilogue";
+        rule.root = OpType::MatMul;
+        rule.match = hasFusibleEpilogue;
+        rule.rewrite = [](GraphObj &graph, const Operator &op)
+        {
+            auto matmul = as<MatmulObj>(op);
+            auto output = op->getOutput();
+            auto next = output->getTargets()[0];
+            auto bias = matmul->getBias(), residual = matmul->getResidual();
+            auto min = matmul->getMin(), max = matmul->getMax();
+            switch (next->getOpType().underlying())
+            {
+            case OpType::Relu:
+                min = 0.f;
+                break;
+            case OpType::Clip:
+                min = as<ClipObj>(next)->getMin();
+                max = as<ClipObj>(next)->getMax();
+                break;
+            default:
+            {
+                auto other = next->getInputs(0) == output ? next->getInputs(1)
+                                                          : next->getInputs(0);
+                if (!bias && isColumnBias(other, output))
+                    bias = other;
+                else
+                    residual = other;
+            }
+            }
+            // the fused matmul takes over the output of `next`, and erasing
+            // `next` then erases the old matmul
+            auto fusedOutput = next->getOutput();
+            graph.replaceOutput(next, fusedOutput,
+                                graph.addTensor(fusedOutput->getDims(),
+                                                fusedOutput->getDType()));
+            graph.addOpWithOutputs<MatmulObj>(
+                op->getInputs(0), op->getInputs(1), fusedOutput,
+                matmul->getTransA(), matmul->getTransB(), bias, residual, min,
+                max);
+            graph.eraseOperator(next);
+        };
+        return rule;
+    }
+
+    // The Transpose computing `tensor`, if `op` is the only consumer of
+    // `tensor`: moving such a transpose below `op` adds no work.
+    static Ref<TransposeObj> transposeOnlyFeeding(const Tensor &tensor,
+                                                  const Operator &op)
+    {
+        auto transpose = producingTranspose(tensor);
+        for (auto &target : tensor->getTargets())
+            if (target != op)
+                return nullptr;
+        return transpose;
+    }
+
+    // Makes `op`, whose inputs have already been moved to the untransposed
+    // layout, compute its output in that layout too, and transposes that
+    // into the original output tensor.
+    static void transposeOutput(GraphObj &graph, const Operator &op,
+                                const vector<int> &permute)
+    {
+        auto output = op->getOutput();
+        auto dims = output->getDims();
+        Shape untransposed(dims.size());
+        for (size_t i = 0; i < permute.size(); ++i)
+            untransposed[permute[i]] = dims[i];
+        auto tensor = graph.addTensor(untransposed, output->getDType());
+        graph.replaceOutput(op, output, tensor);
+        graph.addOpWithOutputs<TransposeObj>(tensor, output, permute);
+    }
+
+    static bool isElementwise(OpType type)
+    {
+        return type == OpType::Add || type == OpType::Sub ||
+               type == OpType::Mul || type == OpType::Div ||
+               type == OpType::Relu || type == OpType::Clip ||
+               type == OpType::Cast || type == OpType::FusedElementwise;
+    }
+
+    // F(Transpose(a, p), Transpose(b, p)) == Transpose(F(a, b), p) for an
+    // elementwise F. A scalar input needs no transpose, and a constant one
+    // gets the inverse transpose, which fold-constants then precomputes.
+    static RewriteRule sinkTransposeThroughElementwise()
+    {
+        RewriteRule rule;
+        rule.name = "sink-transpose-through-elementwise";
+        rule.match = [](const Operator &op)
+        {
+            if (!isElementwise(op->getOpType()))
+                return false;
+            optional<vector<int>> permute;
+            std::set<Operator> transposes;
+            for (auto &input : op->getInputs())
+                if (auto transpose = transposeOnlyFeeding(input, op))
+                {
+                    if (permute && *permute != transpose->getPermute())
+                        return false;
+                    permute = transpose->getPermute();
+                    transposes.insert(transpose);
+                }
+            if (!permute || permute->size() != op->getOutput()->getRank())
+                return false;
+            // moving a single transpose onto a graph output gains nothing
+            if (transposes.size() == 1 &&
+                op->getOutput()->getTargets().empty())
+                return false;
+            for (auto &input : op->getInputs())
+                if (!transposeOnlyFeeding(input, op) && input->size() != 1 &&
+                    !(input->isConstant() &&
+                      input->getRank() == permute->size()))
+                    return false;
+            return true;
+        };
+        rule.rewrite = [](GraphObj &graph, const Operator &op)
+        {
+            vector<int> permute;
+            for (auto &input : op->getInputs())
+                if (auto transpose = transposeOnlyFeeding(input, op))
+                    permute = transpose->getPermute();
+            vector<int> inverse(permute.size());
+            for (size_t i = 0; i < permute.size(); ++i)
+                inverse[permute[i]] = i;
+
+            auto inputs = op->getInputs();
+            for (size_t i = 0; i < inputs.size(); ++i)
+            {
+                // replaceInput() redirects every slot reading the tensor
+                if (std::find(inputs.begin(), inputs.begin() + i, inputs[i]) !=
+                    inputs.begin() + i)
+                    continue;
+                if (auto transpose = transposeOnlyFeeding(inputs[i], op))
+                    graph.replaceInput(op, inputs[i], transpose->getInputs(0));
+                else if (inputs[i]->size() != 1)
+                    graph.replaceInput(
+                        op, inputs[i],
+                        graph.addOp<TransposeObj>(inputs[i], nullptr, inverse)
+                            ->getOutput());
+            }
+            transposeOutput(graph, op, permute);
+        };
+        return rule;
+    }
+
+    // Concat(Transpose(x_i, p), axis) == Transpose(Concat(x_i, p[axis]), p).
+    static RewriteRule sinkTransposeThroughConcat()
+    {
+        RewriteRule rule;
+        rule.name = "sink-transpose-through-concat";
+        rule.root = OpType::Concat;
+        rule.match = [](const Operator &op)
+        {
+            optional<vector<int>> permute;
+            for (auto &input : op->getInputs())
+            {
+                auto transpose = transposeOnlyFeeding(input, op);
+                if (!transpose ||
+                    (permute && *permute != transpose->getPermute()))
+                    return false;
+                permute = transpose->getPermute();
+            }
+            return true;
+        };
+        rule.rewrite = [](GraphObj &graph, const Operator &op)
+        {
+            auto concat = as<ConcatObj>(op);
+            auto permute = producingTranspose(op->getInputs(0))->getPermute();
+            auto inputs = op->getInputs();
+            for (size_t i = 0; i < inputs.size(); ++i)
+                if (std::find(inputs.begin(), inputs.begin() + i, inputs[i]) ==
+                    inputs.begin() + i)
+                    graph.replaceInput(
+                        op, inputs[i],
+                        producingTranspose(inputs[i])->getInputs(0));
+            concat->setDim(permute[concat->getDim()]);
+            transposeOutput(graph, op, permute);
+        };
+        return rule;
+    }
+
+    // An op reading only constants is run once, now, with the regular
+    // kernel; its outputs become constants and the op goes away, along with
+    // the constants only it read. Constants are the tensors marked with
+    // TensorObj::setConstant() before optimize(), with their data as set
+    // then.
+    static RewriteRule foldConstants()
+    {
+        RewriteRule rule;
+        rule.name = "fold-constants";
+        rule.match = [](const Operator &op)
+        {
+            auto inputs = op->getInputs();
+            auto outputs = op->getOutputs();
+            // a folded graph output would be left with neither source nor
+            // targets
+            return !inputs.empty() &&
+                   std::all_of(inputs.begin(), inputs.end(),
+                               [](const Tensor &t)
+                               { return t->isConstant(); }) &&
+                   std::none_of(outputs.begin(), outputs.end(),
+                                [](const Tensor &t)
+                                { return t->getTargets().empty(); });
+        };
+        rule.rewrite = [](GraphObj &graph, const Operator &op)
+        {
+            auto runtime = graph.getRuntime();
+            TensorVec folded;
+            for (auto &output : op->getOutputs())
+            {
+                auto tensor =
+                    graph.addTensor(output->getDims(), output->getDType());
+                tensor->setConstant();
+                output->setDataBlob(tensor->getDataBlob());
+                folded.push_back(tensor);
+            }
+            auto kernel = KernelRegistry::getInstance().getKernel(
+                {runtime->getDevice(), op->getOpType().underlying()});
+            kernel->compute(op, runtime.get());
+            auto outputs = op->getOutputs();
+            for (size_t i = 0; i < outputs.size(); ++i)
+                graph.replaceAllUses(outputs[i], folded[i]);
+        };
+        return rule;
+    }
+
+    // The inputs and program of an op fuse-elementwise can absorb, or
+    // nullopt for any other op.
+    static optional<std::pair<TensorVec, vector<ElementwiseInstr>>>
+    elementwiseProgram(const Operator &op)
+    {
+        auto dtype = op->getOutput()->getDType();
+        if (!(dtype == DataType::Float32 || dtype == DataType::Float16 ||
+              dtype == DataType::BFloat16))
+            return std::nullopt;
+        auto type = op->getOpType();
+        switch (type.underlying())
+        {
+        case OpType::Add:
+        case OpType::Sub:
+        case OpType::Mul:
+        case OpType::Div:
+            return {{op->getInputs(), {{type, 0, 1}}}};
+        case OpType::Relu:
+            return {{op->getInputs(), {{type, 0}}}};
+        case OpType::Clip:
+        {
+            auto clip = as<ClipObj>(op);
+            return {{op->getInputs(),
+                     {{type, 0, -1, clip->getMin().value_or(-INFINITY),
+                       clip->getMax().value_or(INFINITY)}}}};
+        }
+        case OpType::FusedElementwise:
+            return {{op->getInputs(),
+                     as<FusedElementwiseObj>(op)->getProgram()}};
+        default:
+            return std::nullopt;
+        }
+    }
+
+    // The input of `op` computed by an op fuse-elementwise can merge into
+    // it: one read only by `op`, over the same elements as its output, and
+    // whose program fits beside `op`'s within MAX_FUSED_PROGRAM steps.
+    static Tensor fusibleInput(const Operator &op)
+    {
+        size_t steps = elementwiseProgram(op)->second.size();
+        for (auto &input : op->getInputs())
+        {
+            auto source = input->getSource();
+            if (!source)
+                continue;
+            auto program = elementwiseProgram(source);
+            // a producer fuse-matmul-epilogue can take is left to it
+            auto sourceInputs = source->getInputs();
+            if (!program ||
+                program->second.size() + steps > MAX_FUSED_PROGRAM ||
+                std::any_of(sourceInputs.begin(), sourceInputs.end(),
+                            [](const Tensor &t)
+                            {
+                                return t->getSource() &&
+                                       hasFusibleEpilogue(t->getSource());
+                            }) ||
+                input->getDims() != op->getOutput()->getDims() ||
+                !(input->getDType() == op->getOutput()->getDType()))
+                continue;
+            auto targets = input->getTargets();
+            if (std::all_of(targets.begin(), targets.end(),
+                            [&](const Operator &target)
+                            { return target == op; }))
+                return input;
+        }
+        return nullptr;
+    }
+
+    // Chains and trees of Add, Sub, Mul, Div, Relu and Clip become one
+    // FusedElementwise evaluating them block by block, instead of one pass
+    // over memory and one materialized tensor per op. Each rewrite merges
+    // the producer of an input into its consumer; as a round walks the ops
+    // in topological order, the fused op is offered again when its own
+    // consumer comes up, so a whole chain collapses in a single round into
+    // ops of at most MAX_FUSED_PROGRAM steps.
+    static RewriteRule fuseElementwise()
+    {
+        RewriteRule rule;
+        rule.name = "fuse-elementwise";
+        rule.match = [](const Operator &op)
+        { return elementwiseProgram(op) && fusibleInput(op); };
+        rule.rewrite = [](GraphObj &graph, const Operator &op)
+        {
+            auto fused = fusibleInput(op);
+            auto [producerInputs, producerProgram] =
+                *elementwiseProgram(fused->getSource());
+            auto [consumerInputs, consumerProgram] = *elementwiseProgram(op);
+
+            // the inputs of both ops, each once, except the fused tensor
+            TensorVec inputs;
+            auto slotOf = [&](const Tensor &tensor)
+            {
+                auto it = std::find(inputs.begin(), inputs.end(), tensor);
+                if (it == inputs.end())
+                    it = inputs.insert(it, tensor);
+                return int(it - inputs.begin());
+            };
+            vector<int> producerRegs, consumerRegs;
+            for (auto &input : producerInputs)
+                producerRegs.push_back(slotOf(input));
+            for (auto &input : consumerInputs)
+                consumerRegs.push_back(input == fused ? -1 : slotOf(input));
+
+            // then the producer's steps, then the consumer's, reading the
+            // producer's last register in place of the fused tensor
+            int nInputs = inputs.size();
+            for (size_t i = 0; i < producerProgram.size(); ++i)
+                producerRegs.push_back(nInputs + i);
+            int fusedReg = producerRegs.back();
+            for (auto &reg : consumerRegs)
+                if (reg < 0)
+                    reg = fusedReg;
+            for (size_t i = 0; i < consumerProgram.size(); ++i)
+                consumerRegs.push_back(nInputs + producerProgram.size() + i);
+
+            vector<ElementwiseInstr> program;
+            for (auto [steps, regs] :
+                 {std::make_pair(producerProgram, producerRegs),
+                  std::make_pair(consumerProgram, consumerRegs)})
+                for (auto instr : steps)
+                {
+                    instr.lhs = regs[instr.lhs];
+                    if (instr.rhs >= 0)
+                        instr.rhs = regs[instr.rhs];
+                    program.push_back(instr);
+                }
+
+            auto output = op->getOutput();
+            graph.replaceOutput(
+                op, output,
+                graph.addTensor(output->getDims(), output->getDType()));
+            graph.addOpWithOutputs<FusedElementwiseObj>(inputs, output,
+                                                        program);
+            graph.eraseOperator(op);
+        };
+        return rule;
+    }
+
+    vector<RewriteRule> defaultRewriteRules()
+    {
+        return {foldConstants(),
+                removeIdentityTranspose(),
+                composeTransposes(),
+                foldTransposeIntoMatmul(),
+                fuseMatmulEpilogue(),
+                sinkTransposeThroughElementwise(),
+                sinkTransposeThroughConcat(),
+                fuseElementwise()};
+    }
+
+} // namespace infini
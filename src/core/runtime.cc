@@ -1,27 +1,81 @@
 #include "core/runtime.h"
 #include "core/blob.h"
-#include "core/kernel.h"
+#include "core/executor.h"
 #include "core/graph.h"
 #include "core/kernel.h"
+#include "core/plan.h"
+#include "core/profiler.h"
+#include "core/thread_pool.h"
 #include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <memory>
+#if defined(__unix__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 namespace infini
 {
+    // Pages one worker touches at a time when prefaulting.
+    constexpr size_t PREFAULT_GRAIN = 256;
+
+    static size_t pageSize()
+    {
+#if defined(__unix__)
+        static const size_t size = sysconf(_SC_PAGESIZE);
+        return size;
+#else
+        return 4096;
+#endif
+    }
+
+    NativeCpuRuntimeObj::NativeCpuRuntimeObj()
+        : RuntimeObj(Device::CPU), threadPool(make_ref<ThreadPool>()),
+          profiler(make_ref<Profiler>()) {}
+
     void NativeCpuRuntimeObj::run(const Graph &graph) const
     {
-        const auto &kernelRegistry = KernelRegistry::getInstance();
+        Profiler *active = profiling ? profiler.get() : nullptr;
+        if (executor)
+            executor->run(graph->getPlan(), active);
+        else
+            graph->getPlan().run(active);
+    }
 
-        for (auto &op : graph->getOperators())
-        {
-            auto kernelAttrs = KernelAttrs{device, op->getOpType().underlying()};
-            Kernel *kernel = kernelRegistry.getKernel(kernelAttrs);
-            kernel->compute(op, this);
-        }
+    void NativeCpuRuntimeObj::setInterOpThreads(int n)
+    {
+        IT_ASSERT(n >= 0);
+        if (n == 1)
+            executor.reset();
+        else
+            executor = make_ref<InterOpExecutor>(n);
+    }
+
+    int NativeCpuRuntimeObj::getInterOpThreads() const
+    {
+        return executor ? executor->getNumThreads() : 1;
+    }
+
+    void NativeCpuRuntimeObj::setNumThreads(int n, const vector<int> &affinity)
+    {
+        threadPool = make_ref<ThreadPool>(n, affinity);
+    }
+
+    int NativeCpuRuntimeObj::getNumThreads() const
+    {
+        return threadPool->getNumThreads();
     }
 
     string NativeCpuRuntimeObj::toString() const { return "CPU Runtime"; }
 
+    void NativeCpuRuntimeObj::setAllocPolicy(const CpuAllocPolicy &policy)
+    {
+        IT_ASSERT(policy.alignment >= sizeof(void *) &&
+                      (policy.alignment & (policy.alignment - 1)) == 0,
+                  "alignment must be a power of two");
+        allocPolicy = policy;
+    }
+
     void NativeCpuRuntimeObj::dealloc(void *ptr)
     {
         return free(ptr);
@@ -29,8 +83,31 @@ namespace infini
 
     void *NativeCpuRuntimeObj::alloc(size_t size)
     {
-        return calloc((size + sizeof(uint64_t) - 1) / sizeof(uint64_t),
-                      sizeof(uint64_t));
+        const size_t page = pageSize();
+        const bool huge = allocPolicy.hugePages && size >= HUGE_PAGE_BYTES;
+        size_t alignment = huge          ? HUGE_PAGE_BYTES
+                           : size >= page ? std::max(allocPolicy.alignment, page)
+                                          : allocPolicy.alignment;
+        // aligned_alloc takes a whole number of alignments
+        size_t bytes = std::max(alignment,
+                                (size + alignment - 1) / alignment * alignment);
+        void *ptr = std::aligned_alloc(alignment, bytes);
+        IT_ASSERT(ptr != nullptr, "out of memory");
+#if defined(MADV_HUGEPAGE)
+        // only advice: without transparent huge pages it fails harmlessly
+        if (huge)
+            madvise(ptr, bytes, MADV_HUGEPAGE);
+#endif
+        if (allocPolicy.prefault && bytes >= page)
+        {
+            auto base = static_cast<volatile char *>(ptr);
+            threadPool->parallel_for(
+                0, bytes / page, PREFAULT_GRAIN, [&](size_t begin, size_t end)
+                {
+                    for (size_t p = begin; p < end; ++p)
+                        base[p * page] = 0; });
+        }
+        return ptr;
     }
 
 } // namespace infini
@@ -0,0 +1,217 @@
+#include "core/schedule.h"
+#include <queue>
+#include <unordered_map>
+
+namespace infini
+{
+
+    namespace
+    {
+        // The tensors of a list of operators, numbered, with what the
+        // schedulers need to track live bytes.
+        struct ScheduleGraph
+        {
+            struct Node
+            {
+                // distinct input tensors computed by another op, outputs
+                vector<int> inputs, outputs;
+                size_t outputBytes = 0;
+            };
+            struct Value
+            {
+                size_t bytes = 0;
+                // -1 for graph inputs and constants
+                int producer = -1;
+                // distinct consuming ops; none for graph outputs
+                vector<int> consumers;
+            };
+
+            vector<Node> nodes;
+            vector<Value> values;
+            // bytes of the graph inputs, live throughout
+            size_t baseline = 0;
+
+            explicit ScheduleGraph(const OpVec &ops) : nodes(ops.size())
+            {
+                std::unordered_map<OperatorObj *, int> opIds;
+                for (size_t i = 0; i < ops.size(); ++i)
+                    opIds[ops[i].get()] = i;
+                std::unordered_map<TensorObj *, int> ids;
+                auto idOf = [&](const Tensor &tensor)
+                {
+                    auto [it, added] = ids.try_emplace(tensor.get(), values.size());
+                    if (added)
+                    {
+                        Value value;
+                        value.bytes = tensor->isConstant() ? 0 : tensor->getBytes();
+                        auto source = tensor->getSource();
+                        if (source && opIds.count(source.get()))
+                            value.producer = opIds[source.get()];
+                        values.push_back(value);
+                    }
+                    return it->second;
+                };
+                for (size_t i = 0; i < ops.size(); ++i)
+                {
+                    for (auto &output : ops[i]->getOutputs())
+                    {
+                        int id = idOf(output);
+                        nodes[i].outputs.push_back(id);
+                        nodes[i].outputBytes += values[id].bytes;
+                    }
+                    for (auto &input : ops[i]->getInputs())
+                    {
+                        int id = idOf(input);
+                        auto &consumers = values[id].consumers;
+                        // an op may read the same tensor more than once
+                        if (!consumers.empty() && consumers.back() == int(i))
+                            continue;
+                        consumers.push_back(i);
+                        if (values[id].producer >= 0)
+                            nodes[i].inputs.push_back(id);
+                    }
+                }
+                for (auto &value : values)
+                    if (value.producer < 0)
+                        baseline += value.bytes;
+            }
+        };
+    } // namespace
+
+    size_t peakLiveBytes(const OpVec &ops)
+    {
+        ScheduleGraph graph(ops);
+        vector<size_t> remaining;
+        for (auto &value : graph.values)
+            remaining.push_back(value.consumers.size());
+        size_t live = graph.baseline, peak = live;
+        for (auto &node : graph.nodes)
+        {
+            // the outputs are allocated before the inputs are released
+            live += node.outputBytes;
+            peak = std::max(peak, live);
+            for (int input : node.inputs)
+                if (--remaining[input] == 0)
+                    live -= graph.values[input].bytes;
+        }
+        return peak;
+    }
+
+    // The optimal order: dp over the sets of ops already run, which fix the
+    // live bytes, of the smallest peak reaching each set.
+    static vector<int> exactSchedule(const ScheduleGraph &graph)
+    {
+        const size_t n = graph.nodes.size();
+        const uint32_t all = (uint32_t(1) << n) - 1;
+        vector<uint32_t> needs(n, 0), readers(graph.values.size(), 0);
+        for (size_t i = 0; i < n; ++i)
+            for (int input : graph.nodes[i].inputs)
+                needs[i] |= uint32_t(1) << graph.values[input].producer;
+        for (size_t v = 0; v < graph.values.size(); ++v)
+            for (int consumer : graph.values[v].consumers)
+                readers[v] |= uint32_t(1) << consumer;
+
+        vector<size_t> peak(size_t(all) + 1, SIZE_MAX);
+        vector<int8_t> last(size_t(all) + 1, -1);
+        peak[0] = graph.baseline;
+        for (uint32_t done = 0; done < all; ++done)
+        {
+            if (peak[done] == SIZE_MAX)
+                continue;
+            size_t live = graph.baseline;
+            for (size_t v = 0; v < graph.values.size(); ++v)
+            {
+                auto &value = graph.values[v];
+                if (value.producer >= 0 && (done >> value.producer & 1) &&
+                    (value.consumers.empty() || (readers[v] & ~done)))
+                    live += value.bytes;
+            }
+            for (size_t i = 0; i < n; ++i)
+            {
+                uint32_t bit = uint32_t(1) << i;
+                if ((done & bit) || (needs[i] & ~done))
+                    continue;
+                size_t next = std::max(peak[done],
+                                       live + graph.nodes[i].outputBytes);
+                if (next < peak[done | bit])
+                {
+                    peak[done | bit] = next;
+                    last[done | bit] = i;
+                }
+            }
+        }
+        vector<int> order(n);
+        for (uint32_t done = all; done; done &= ~(uint32_t(1) << last[done]))
+            order[__builtin_popcount(done) - 1] = last[done];
+        return order;
+    }
+
+    static vector<int> greedySchedule(const ScheduleGraph &graph)
+    {
+        const size_t n = graph.nodes.size();
+        vector<size_t> remaining, pending(n);
+        for (auto &value : graph.values)
+            remaining.push_back(value.consumers.size());
+        for (size_t i = 0; i < n; ++i)
+            pending[i] = graph.nodes[i].inputs.size();
+        vector<bool> scheduled(n, false);
+        // growth of the live bytes if op i ran now
+        auto delta = [&](int i)
+        {
+            auto &node = graph.nodes[i];
+            int64_t d = node.outputBytes;
+            for (int input : node.inputs)
+                if (remaining[input] == 1)
+                    d -= graph.values[input].bytes;
+            return d;
+        };
+        // keys go stale as tensors lose readers: they are checked when
+        // popped, and refreshed when an op becomes the last reader of one
+        using Entry = std::pair<int64_t, int>;
+        std::priority_queue<Entry, vector<Entry>, std::greater<Entry>> ready;
+        for (size_t i = 0; i < n; ++i)
+            if (pending[i] == 0)
+                ready.push({delta(i), i});
+
+        vector<int> order;
+        order.reserve(n);
+        while (!ready.empty())
+        {
+            auto [key, i] = ready.top();
+            ready.pop();
+            if (scheduled[i])
+                continue;
+            if (auto d = delta(i); d != key)
+            {
+                ready.push({d, i});
+                continue;
+            }
+            scheduled[i] = true;
+            order.push_back(i);
+            for (int input : graph.nodes[i].inputs)
+                if (--remaining[input] == 1)
+                    for (int consumer : graph.values[input].consumers)
+                        if (!scheduled[consumer] && pending[consumer] == 0)
+                            ready.push({delta(consumer), consumer});
+            for (int output : graph.nodes[i].outputs)
+                for (int consumer : graph.values[output].consumers)
+                    if (--pending[consumer] == 0)
+                        ready.push({delta(consumer), consumer});
+        }
+        IT_ASSERT(order.size() == n, "the operators are not in a topological order");
+        return order;
+    }
+
+    OpVec scheduleForMemory(const OpVec &ops, size_t exactLimit)
+    {
+        ScheduleGraph graph(ops);
+        auto order = ops.size() <= std::min<size_t>(exactLimit, 20)
+                         ? exactSchedule(graph)
+                         : greedySchedule(graph);
+        OpVec scheduled;
+        for (int i : order)
+            scheduled.push_back(ops[i]);
+        return scheduled;
+    }
+
+} // namespace infini
@@ -7,8 +7,21 @@
 
 namespace infini {
 
+    // Row-major element strides of `shape`.
+    static Shape contiguousStrides(const Shape &shape)
+    {
+        Shape strides(shape.size());
+        for (size_t d = shape.size(), p = 1; d-- > 0;)
+        {
+            strides[d] = p;
+            p *= shape[d];
+        }
+        return strides;
+    }
+
     TensorObj::TensorObj(Shape shape_, DataType dtype, Runtime runtime)
         : dim(shape_.size()), dtype(dtype), runtime(runtime), shape(std::move(shape_)),
+          strides(contiguousStrides(shape)),
           _size(std::accumulate(shape.begin(), shape.end(), 1, std::multiplies{})) {}
 
     string TensorObj::toString() const
@@ -22,7 +35,7 @@ namespace infini {
         string ret = "Tensor " + std::to_string(guid) + ", Fuid " +
                      std::to_string(fuid) + ", shape " + vecToString(shape) +
                      ", dtype " + dtype.toString() + ", " + runtime->toString() +
-                     ", " + ss.str() + "\n";
+                     ", " + ss.str() + (constant ? ", constant" : "") + "\n";
         vector<UidBaseType> targetGuids;
         for (const auto &op : targets)
             targetGuids.emplace_back(op.lock()->getGuid());
@@ -36,6 +49,8 @@ namespace infini {
 
 void TensorObj::setShape(Shape shape_) {
     shape = shape_;
+    strides = contiguousStrides(shape);
+    offset = 0;
     size_t size = std::accumulate(shape.begin(), shape.end(), 1,
                                   [](auto acc, auto x) { return acc * x; });
     _size = size;
@@ -43,6 +58,7 @@ void TensorObj::setShape(Shape shape_) {
 
 void TensorObj::printData() const {
     IT_ASSERT(data != nullptr);
+    IT_ASSERT(isContiguous());
     if (!runtime->isCpu())
         IT_TODO_HALT();
 
@@ -73,6 +89,7 @@ void TensorObj::printData() const {
 bool TensorObj::equalData(const Tensor &rhs, double relativeError) const {
     IT_ASSERT(data != nullptr);
     IT_ASSERT(rhs->data != nullptr);
+    IT_ASSERT(isContiguous() && rhs->isContiguous());
     IT_ASSERT(getDType() == rhs->getDType());
     IT_ASSERT(runtime->isCpu());
     IT_ASSERT(rhs->getRuntime()->isCpu());
@@ -108,9 +125,36 @@ bool TensorObj::equalData(const Tensor &rhs, double relativeError) const {
 void TensorObj::setData(
     const std::function<void(void *, size_t, DataType)> &generator) const {
     IT_ASSERT(data != nullptr);
+    IT_ASSERT(isContiguous());
     generator(getRawDataPtr<void *>(), size(), dtype);
 }
 
-void TensorObj::setDataBlob(const Blob &blob) { this->data = blob; }
+void TensorObj::setDataBlob(const Blob &blob) {
+    data = blob;
+    strides = contiguousStrides(shape);
+    offset = 0;
+}
+
+void TensorObj::setView(const Blob &blob, Shape strides_, size_t offset_) {
+    IT_ASSERT(strides_.size() == shape.size());
+    data = blob;
+    strides = std::move(strides_);
+    offset = offset_;
+}
+
+bool TensorObj::isContiguous() const {
+    // the stride of a unit dim is never used
+    for (size_t d = shape.size(), p = 1; d-- > 0; p *= shape[d])
+        if (shape[d] != 1 && size_t(strides[d]) != p)
+            return false;
+    return true;
+}
+
+void TensorObj::setConstant() {
+    IT_ASSERT(!getSource(), "only a graph input can be constant");
+    if (!constant)
+        data = BlobObj::allocate(runtime, getBytes());
+    constant = true;
+}
 
 }; // namespace infini
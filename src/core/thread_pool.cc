@@ -0,0 +1,148 @@
+#include "core/thread_pool.h"
+#include <algorithm>
+#include <cstdlib>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace infini
+{
+
+    // A loop is cut into at most this many chunks per thread, which evens
+    // out chunks of unequal cost without making every chunk tiny.
+    constexpr size_t CHUNKS_PER_THREAD = 4;
+
+    static int defaultNumThreads()
+    {
+        if (const char *env = std::getenv("INFINI_NUM_THREADS"))
+        {
+            int n = std::atoi(env);
+            if (n > 0)
+                return n;
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    ThreadPool::ThreadPool(int numThreads, const vector<int> &affinity)
+        : numThreads(numThreads > 0 ? numThreads : defaultNumThreads())
+    {
+        IT_ASSERT(numThreads >= 0);
+        for (int i = 1; i < this->numThreads; ++i)
+        {
+            int cpu = affinity.empty() ? -1
+                                       : affinity[(i - 1) % affinity.size()];
+            workers.emplace_back(&ThreadPool::workerLoop, this, cpu);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    void ThreadPool::parallel_for(size_t begin, size_t end, size_t grain,
+                                  const Body &body)
+    {
+        if (end <= begin)
+            return;
+        const size_t n = end - begin;
+        grain = std::max<size_t>(grain, 1);
+        size_t numChunks = std::min(n / grain, CHUNKS_PER_THREAD * numThreads);
+        if (numChunks <= 1 || workers.empty())
+        {
+            body(begin, end);
+            return;
+        }
+
+        Job job;
+        job.body = &body;
+        job.begin = begin;
+        job.end = end;
+        job.chunk = (n + numChunks - 1) / numChunks;
+        job.numChunks = (n + job.chunk - 1) / job.chunk;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(&job);
+        }
+        wake.notify_all();
+
+        while (runChunk(job))
+            ;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = std::find(jobs.begin(), jobs.end(), &job);
+        if (it != jobs.end())
+            jobs.erase(it);
+        done.wait(lock, [&]
+                  { return job.finished.load() == job.numChunks &&
+                           job.users == 0; });
+        if (job.error)
+            std::rethrow_exception(job.error);
+    }
+
+    bool ThreadPool::runChunk(Job &job)
+    {
+        size_t c = job.next.fetch_add(1);
+        if (c >= job.numChunks)
+            return false;
+        size_t begin = job.begin + c * job.chunk;
+        try
+        {
+            (*job.body)(begin, std::min(job.end, begin + job.chunk));
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!job.error)
+                job.error = std::current_exception();
+        }
+        if (job.finished.fetch_add(1) + 1 == job.numChunks)
+        {
+            // notify under the lock, the caller may be about to wait
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+        return true;
+    }
+
+    void ThreadPool::workerLoop(int cpu)
+    {
+#if defined(__linux__)
+        if (cpu >= 0)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+#endif
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wake.wait(lock, [this]
+                      { return stopping || !jobs.empty(); });
+            if (stopping)
+                return;
+            Job &job = *jobs.front();
+            ++job.users;
+            lock.unlock();
+            while (runChunk(job))
+                ;
+            lock.lock();
+            // every chunk is claimed, later workers need not look at it
+            auto it = std::find(jobs.begin(), jobs.end(), &job);
+            if (it != jobs.end())
+                jobs.erase(it);
+            if (--job.users == 0)
+                done.notify_all();
+        }
+    }
+
+} // namespace infini
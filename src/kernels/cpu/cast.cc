@@ -0,0 +1,333 @@
+#include "operators/unary.h"
+#include "core/kernel.h"
+#include "utils/cpu_features.h"
+#include "utils/simd_loops.h"
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace infini {
+
+// Elements per parallel chunk; smaller tensors stay single-threaded.
+constexpr size_t CAST_GRAIN = 1 << 16;
+
+using CastLoop = void (*)(void *out, const void *in, size_t n);
+
+// Out-of-range values saturate to the limits of the target type and NaN
+// becomes 0, which is what the saturating packs below compute as well.
+template <typename From, typename To> static To castValue(From x) {
+    using Limits = std::numeric_limits<To>;
+    if constexpr (std::is_floating_point_v<From> && std::is_integral_v<To>) {
+        if (std::isnan(x))
+            return 0;
+        // max() rounds up to a power of two in From, hence the >=
+        if (x >= From(Limits::max()))
+            return Limits::max();
+        if (x <= From(Limits::min()))
+            return Limits::min();
+        return To(x);
+    } else if constexpr (std::is_integral_v<From> && std::is_integral_v<To>) {
+        static_assert(sizeof(From) < sizeof(int64_t) ||
+                      std::is_signed_v<From>);
+        return To(std::clamp<int64_t>(x, Limits::min(), Limits::max()));
+    } else {
+        return To(x);
+    }
+}
+
+template <typename From, typename To>
+static void castLoop(void *out, const void *in, size_t n) {
+    auto dst = static_cast<To *>(out);
+    auto src = static_cast<const From *>(in);
+    for (size_t i = 0; i < n; ++i)
+        dst[i] = castValue<From, To>(src[i]);
+}
+
+static void copyLoop(void *out, const void *in, size_t n) {
+    std::memcpy(out, in, n * sizeof(float));
+}
+
+template <void (*HalfConvertLoops::*Loop)(float *, const uint16_t *, size_t)>
+static void widenLoop(void *out, const void *in, size_t n) {
+    (getHalfConvertLoops().*Loop)(static_cast<float *>(out),
+                                  static_cast<const uint16_t *>(in), n);
+}
+
+template <void (*HalfConvertLoops::*Loop)(uint16_t *, const float *, size_t)>
+static void narrowLoop(void *out, const void *in, size_t n) {
+    (getHalfConvertLoops().*Loop)(static_cast<uint16_t *>(out),
+                                  static_cast<const float *>(in), n);
+}
+
+#if defined(__x86_64__)
+template <typename T>
+__attribute__((target("sse4.2"))) static inline __m128i loadu128(const T *p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+template <typename T>
+__attribute__((target("avx2"))) static inline __m256i loadu256(const T *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+__attribute__((target("sse4.2"))) static void
+castInt32ToInt16Sse42(void *out, const void *in, size_t n) {
+    auto dst = static_cast<int16_t *>(out);
+    auto src = static_cast<const int32_t *>(in);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         _mm_packs_epi32(loadu128(src + i),
+                                         loadu128(src + i + 4)));
+    castLoop<int32_t, int16_t>(dst + i, src + i, n - i);
+}
+
+__attribute__((target("sse4.2"))) static void
+castInt32ToInt8Sse42(void *out, const void *in, size_t n) {
+    auto dst = static_cast<int8_t *>(out);
+    auto src = static_cast<const int32_t *>(in);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i lo = _mm_packs_epi32(loadu128(src + i), loadu128(src + i + 4));
+        __m128i hi =
+            _mm_packs_epi32(loadu128(src + i + 8), loadu128(src + i + 12));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         _mm_packs_epi16(lo, hi));
+    }
+    castLoop<int32_t, int8_t>(dst + i, src + i, n - i);
+}
+
+// The 256-bit packs work within 128-bit lanes, so their results are put back
+// in order with a cross-lane permute.
+__attribute__((target("avx2"))) static void
+castInt32ToInt16Avx2(void *out, const void *in, size_t n) {
+    auto dst = static_cast<int16_t *>(out);
+    auto src = static_cast<const int32_t *>(in);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i x = _mm256_packs_epi32(loadu256(src + i), loadu256(src + i + 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                            _mm256_permute4x64_epi64(x, 0xD8));
+    }
+    castLoop<int32_t, int16_t>(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void
+castInt32ToInt8Avx2(void *out, const void *in, size_t n) {
+    auto dst = static_cast<int8_t *>(out);
+    auto src = static_cast<const int32_t *>(in);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i lo =
+            _mm256_packs_epi32(loadu256(src + i), loadu256(src + i + 8));
+        __m256i hi =
+            _mm256_packs_epi32(loadu256(src + i + 16), loadu256(src + i + 24));
+        __m256i x = _mm256_packs_epi16(lo, hi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                            _mm256_permutevar8x32_epi32(x, order));
+    }
+    castLoop<int32_t, int8_t>(dst + i, src + i, n - i);
+}
+
+// cvttps returns INT32_MIN for NaN and out-of-range inputs, which is only
+// right for large negative ones; the other two are patched with masks.
+__attribute__((target("avx2"))) static void
+castFloatToInt32Avx2(void *out, const void *in, size_t n) {
+    auto dst = static_cast<int32_t *>(out);
+    auto src = static_cast<const float *>(in);
+    const __m256 limit = _mm256_set1_ps(2147483648.f);
+    const __m256i maxValue = _mm256_set1_epi32(INT32_MAX);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(src + i);
+        __m256i r = _mm256_cvttps_epi32(x);
+        __m256 over = _mm256_cmp_ps(x, limit, _CMP_GE_OQ);
+        __m256 ordered = _mm256_cmp_ps(x, x, _CMP_ORD_Q);
+        r = _mm256_blendv_epi8(r, maxValue, _mm256_castps_si256(over));
+        r = _mm256_and_si256(r, _mm256_castps_si256(ordered));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), r);
+    }
+    castLoop<float, int32_t>(dst + i, src + i, n - i);
+}
+
+// the AVX-512 down-converts start from an undefined vector, which GCC 12
+// reports as maybe-uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f"))) static void
+castInt32ToInt16Avx512(void *out, const void *in, size_t n) {
+    auto dst = static_cast<int16_t *>(out);
+    auto src = static_cast<const int32_t *>(in);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                            _mm512_cvtsepi32_epi16(_mm512_loadu_si512(src + i)));
+    castLoop<int32_t, int16_t>(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx512f"))) static void
+castInt32ToInt8Avx512(void *out, const void *in, size_t n) {
+    auto dst = static_cast<int8_t *>(out);
+    auto src = static_cast<const int32_t *>(in);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         _mm512_cvtsepi32_epi8(_mm512_loadu_si512(src + i)));
+    castLoop<int32_t, int8_t>(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx512f"))) static void
+castInt64ToInt32Avx512(void *out, const void *in, size_t n) {
+    auto dst = static_cast<int32_t *>(out);
+    auto src = static_cast<const int64_t *>(in);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                            _mm512_cvtsepi64_epi32(_mm512_loadu_si512(src + i)));
+    castLoop<int64_t, int32_t>(dst + i, src + i, n - i);
+}
+
+// vpmovusqd saturates unsigned inputs, so negative ones are clamped to 0
+// first.
+__attribute__((target("avx512f"))) static void
+castInt64ToUint32Avx512(void *out, const void *in, size_t n) {
+    auto dst = static_cast<uint32_t *>(out);
+    auto src = static_cast<const int64_t *>(in);
+    const __m512i zero = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_max_epi64(_mm512_loadu_si512(src + i), zero);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                            _mm512_cvtusepi64_epi32(x));
+    }
+    castLoop<int64_t, uint32_t>(dst + i, src + i, n - i);
+}
+#pragma GCC diagnostic pop
+#endif
+
+// The loop for `type` on this host, and the input type it expects.
+static pair<DataType, CastLoop> selectCastLoop(CastType type) {
+#if defined(__x86_64__)
+    const SimdLevel level = getSimdLevel();
+    const bool sse42 = level >= SimdLevel::SSE42,
+               avx2 = level >= SimdLevel::AVX2,
+               avx512 = level >= SimdLevel::AVX512;
+#endif
+    switch (type) {
+    case CastType::Float2Float16:
+        return {DataType::Float32, narrowLoop<&HalfConvertLoops::floatToHalf>};
+    case CastType::Float2Int64:
+        return {DataType::Float32, castLoop<float, int64_t>};
+    case CastType::Float2Int32:
+#if defined(__x86_64__)
+        if (avx2)
+            return {DataType::Float32, castFloatToInt32Avx2};
+#endif
+        return {DataType::Float32, castLoop<float, int32_t>};
+    case CastType::Float2Int16:
+        return {DataType::Float32, castLoop<float, int16_t>};
+    case CastType::Float2Int8:
+        return {DataType::Float32, castLoop<float, int8_t>};
+    case CastType::Float2BFloat16:
+        return {DataType::Float32,
+                narrowLoop<&HalfConvertLoops::floatToBfloat16>};
+    case CastType::Int322Float:
+        return {DataType::Int32, castLoop<int32_t, float>};
+    case CastType::Int322Int8:
+#if defined(__x86_64__)
+        if (avx512)
+            return {DataType::Int32, castInt32ToInt8Avx512};
+        if (avx2)
+            return {DataType::Int32, castInt32ToInt8Avx2};
+        if (sse42)
+            return {DataType::Int32, castInt32ToInt8Sse42};
+#endif
+        return {DataType::Int32, castLoop<int32_t, int8_t>};
+    case CastType::Int322Int16:
+#if defined(__x86_64__)
+        if (avx512)
+            return {DataType::Int32, castInt32ToInt16Avx512};
+        if (avx2)
+            return {DataType::Int32, castInt32ToInt16Avx2};
+        if (sse42)
+            return {DataType::Int32, castInt32ToInt16Sse42};
+#endif
+        return {DataType::Int32, castLoop<int32_t, int16_t>};
+    case CastType::Int322Int64:
+        return {DataType::Int32, castLoop<int32_t, int64_t>};
+    case CastType::Int162Float:
+        return {DataType::Int16, castLoop<int16_t, float>};
+    case CastType::Int162Int32:
+        return {DataType::Int16, castLoop<int16_t, int32_t>};
+    case CastType::Int82Float:
+        return {DataType::Int8, castLoop<int8_t, float>};
+    case CastType::Int82Int16:
+        return {DataType::Int8, castLoop<int8_t, int16_t>};
+    case CastType::Int82Int32:
+        return {DataType::Int8, castLoop<int8_t, int32_t>};
+    case CastType::Uint82Float:
+        return {DataType::UInt8, castLoop<uint8_t, float>};
+    case CastType::Uint82Int32:
+        return {DataType::UInt8, castLoop<uint8_t, int32_t>};
+    case CastType::Uint82Int64:
+        return {DataType::UInt8, castLoop<uint8_t, int64_t>};
+    case CastType::Int642Int32:
+#if defined(__x86_64__)
+        if (avx512)
+            return {DataType::Int64, castInt64ToInt32Avx512};
+#endif
+        return {DataType::Int64, castLoop<int64_t, int32_t>};
+    case CastType::Int642Uint32:
+#if defined(__x86_64__)
+        if (avx512)
+            return {DataType::Int64, castInt64ToUint32Avx512};
+#endif
+        return {DataType::Int64, castLoop<int64_t, uint32_t>};
+    case CastType::Int642Float:
+        return {DataType::Int64, castLoop<int64_t, float>};
+    case CastType::Uint322Int64:
+        return {DataType::UInt32, castLoop<uint32_t, int64_t>};
+    case CastType::Float162Float:
+        return {DataType::Float16, widenLoop<&HalfConvertLoops::halfToFloat>};
+    case CastType::BFloat162Float:
+        return {DataType::BFloat16,
+                widenLoop<&HalfConvertLoops::bfloat16ToFloat>};
+    case CastType::Float2Float:
+        return {DataType::Float32, copyLoop};
+    default:
+        IT_TODO_HALT();
+    }
+}
+
+class NativeCast : public CpuKernelWithoutConfig {
+    KernelRoutine compile(const Operator &_op,
+                          const RuntimeObj *context) const override {
+        auto op = as<CastObj>(_op);
+        auto input = op->getInputs(0), output = op->getOutput();
+        auto [inType, loop] = selectCastLoop(op->getType());
+        IT_ASSERT(input->getDType() == inType);
+
+        const size_t n = output->size();
+        const size_t inSize = inType.getSize();
+        const size_t outSize = output->getDType().getSize();
+        auto src = input->getRawDataPtr<char *>();
+        auto dst = output->getRawDataPtr<char *>();
+        return [=, loop = loop] {
+            getThreadPool(context).parallel_for(
+                0, n, CAST_GRAIN, [&](size_t begin, size_t end) {
+                    loop(dst + begin * outSize, src + begin * inSize,
+                         end - begin);
+                });
+        };
+    }
+
+    void compute(const Operator &_op,
+                 const RuntimeObj *context) const override {
+        compile(_op, context)();
+    }
+};
+
+REGISTER_KERNEL(Device::CPU, OpType::Cast, NativeCast, "Cast_CPU");
+
+} // namespace infini
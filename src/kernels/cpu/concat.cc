@@ -1,61 +1,118 @@
 #include "operators/concat.h"
 #include "core/kernel.h"
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 namespace infini {
 
+// Contiguous runs are copied in chunks of at most this many bytes, so that
+// a concat of a few large blocks still spreads over all threads.
+constexpr size_t CONCAT_CHUNK_BYTES = 1 << 18;
+// Outputs at least this large are written with non-temporal stores, which
+// skip reading the destination lines into a cache they would only pollute.
+constexpr size_t CONCAT_STREAM_BYTES = 1 << 22;
+
+static void streamCopy(void *dst, const void *src, size_t bytes) {
+#if defined(__x86_64__)
+    auto d = static_cast<char *>(dst);
+    auto s = static_cast<const char *>(src);
+    size_t head = (16 - reinterpret_cast<uintptr_t>(d) % 16) % 16;
+    if (head >= bytes) {
+        std::memcpy(d, s, bytes);
+        return;
+    }
+    std::memcpy(d, s, head);
+    d += head, s += head, bytes -= head;
+    for (; bytes >= 64; bytes -= 64, d += 64, s += 64) {
+        auto in = reinterpret_cast<const __m128i *>(s);
+        auto out = reinterpret_cast<__m128i *>(d);
+        __m128i x0 = _mm_loadu_si128(in), x1 = _mm_loadu_si128(in + 1),
+                x2 = _mm_loadu_si128(in + 2), x3 = _mm_loadu_si128(in + 3);
+        _mm_stream_si128(out, x0);
+        _mm_stream_si128(out + 1, x1);
+        _mm_stream_si128(out + 2, x2);
+        _mm_stream_si128(out + 3, x3);
+    }
+    std::memcpy(d, s, bytes);
+#else
+    std::memcpy(dst, src, bytes);
+#endif
+}
+
 class NaiveConcat : public CpuKernelWithoutConfig {
-    template <typename T>
-    void doCompute(const Operator &_op, const RuntimeObj *context) const {
+    KernelRoutine compile(const Operator &_op,
+                          const RuntimeObj *context) const override {
         auto op = as<ConcatObj>(_op);
-        auto inputs = op->getInputs(), outputs = op->getOutputs();
+        const auto &inputs = op->getInputs();
+        auto output = op->getOutput();
         auto dim = op->getDim();
-        auto output = outputs[0];
-        std::vector<Shape> iDims;
-        for (auto input : inputs)
-            iDims.emplace_back(input->getDims());
+        const size_t elemSize = output->getDType().getSize();
         const auto &outDim = output->getDims();
-        size_t blockOffsetInner = 1;
-        for (size_t i = outDim.size() - 1; i > (size_t)dim; --i)
-            blockOffsetInner *= outDim[i];
-        size_t blockOffset = outDim[dim] * blockOffsetInner;
-        for (size_t i = 0; i < inputs.size(); ++i) {
-            auto input = inputs[i];
-            auto dimOffset = 0;
-            auto iDim = iDims[i];
-            for (size_t j = 0; j < i; ++j)
-                dimOffset += iDims[j][dim];
-            size_t localBlockOffset = 1;
-            for (size_t i = iDim.size() - 1;
-                 i >= (size_t)dim && i != (size_t)-1; --i)
-                localBlockOffset *= iDim[i];
-            auto innerOffset = blockOffsetInner * dimOffset;
-            auto inSize = input->size();
-            auto inPtr = input->getRawDataPtr<T *>(),
-                 outPtr = output->getRawDataPtr<T *>();
-#pragma omp parallel for
-            for (size_t iOffset = 0; iOffset < inSize; ++iOffset) {
-                auto oOffset = iOffset % localBlockOffset + innerOffset +
-                               iOffset / localBlockOffset * blockOffset;
-                outPtr[oOffset] = inPtr[iOffset];
-            }
+
+        // Every input contributes one contiguous run per index of the dims
+        // before `dim`. Runs are cut into chunks, each chunk of each outer
+        // index is a work item.
+        size_t outer = 1, innerBytes = elemSize;
+        for (int i = 0; i < dim; ++i)
+            outer *= outDim[i];
+        for (size_t i = dim + 1; i < outDim.size(); ++i)
+            innerBytes *= outDim[i];
+        const size_t outBlockBytes = outDim[dim] * innerBytes;
+
+        struct Chunk {
+            const char *src;
+            size_t srcBlockBytes, dstOffset, bytes;
+        };
+        auto outPtr = output->getRawDataPtr<char *>();
+        vector<Chunk> chunks;
+        size_t dimOffset = 0;
+        for (auto &input : inputs) {
+            size_t blockBytes = input->getDims()[dim] * innerBytes;
+            auto src = input->getRawDataPtr<char *>();
+            // dataMalloc() may have computed the input in its slice already
+            if (outer != 1 || src != outPtr + dimOffset * innerBytes)
+                for (size_t b = 0; b < blockBytes; b += CONCAT_CHUNK_BYTES)
+                    chunks.push_back(
+                        {src + b, blockBytes, dimOffset * innerBytes + b,
+                         std::min(CONCAT_CHUNK_BYTES, blockBytes - b)});
+            dimOffset += input->getDims()[dim];
         }
+
+        if (chunks.empty())
+            return [] {};
+        const size_t outBytes = output->getBytes();
+        return [=, chunks = std::move(chunks)] {
+            const size_t nChunks = chunks.size(), nWork = outer * nChunks;
+            const bool stream = outBytes >= CONCAT_STREAM_BYTES;
+            // one work item per task once there is more than a chunk to copy
+            const size_t grain = outBytes > CONCAT_CHUNK_BYTES ? 1 : nWork;
+            getThreadPool(context).parallel_for(
+                0, nWork, grain, [&](size_t begin, size_t end) {
+                    for (size_t w = begin; w < end; ++w) {
+                        size_t o = w / nChunks;
+                        const auto &chunk = chunks[w % nChunks];
+                        char *dst =
+                            outPtr + o * outBlockBytes + chunk.dstOffset;
+                        const char *src = chunk.src + o * chunk.srcBlockBytes;
+                        if (stream)
+                            streamCopy(dst, src, chunk.bytes);
+                        else
+                            std::memcpy(dst, src, chunk.bytes);
+                    }
+#if defined(__x86_64__)
+                    // order this thread's streaming stores before the
+                    // consumers read them
+                    if (stream)
+                        _mm_sfence();
+#endif
+                });
+        };
     }
 
     void compute(const Operator &_op,
                  const RuntimeObj *context) const override {
-#define CASE(N)                                                                \
-    case N:                                                                    \
-        doCompute<DT<N>::t>(_op, context)
-
-        int dataTypeIdx = _op->getDType().getIndex();
-        switch (dataTypeIdx) {
-            CASE(1); // DataType::Float32
-            break;
-            CASE(12); // DataType::UInt32
-            break;
-        default:
-            IT_TODO_HALT();
-        }
+        compile(_op, context)();
     }
 };
 
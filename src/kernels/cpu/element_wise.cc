@@ -1,9 +1,64 @@
 #include "operators/element_wise.h"
 #include "core/kernel.h"
 #include "utils/operator_utils.h"
+#include "utils/simd_loops.h"
 
 namespace infini
 {
+    // Below this many output elements the loops stay single-threaded.
+    constexpr size_t ELEMENT_WISE_GRAIN = 1 << 15;
+    // Elements of a strided operand gathered into a dense run at a time.
+    constexpr size_t STRIDED_BLOCK = 512;
+
+    // BinaryLoops over Float16 or BFloat16 data: each run is widened to
+    // Float32 HALF_BLOCK elements at a time, computed with the float loops
+    // and narrowed back, so the result is rounded once per element.
+    struct HalfBinaryLoops
+    {
+        BinaryLoops<float> loops;
+        HalfFormat format;
+
+        void vv(uint16_t *out, const uint16_t *a, const uint16_t *b,
+                size_t n) const
+        {
+            float fa[HALF_BLOCK], fb[HALF_BLOCK];
+            for (size_t i = 0; i < n; i += HALF_BLOCK)
+            {
+                size_t len = std::min(HALF_BLOCK, n - i);
+                format.toFloat(fa, a + i, len);
+                format.toFloat(fb, b + i, len);
+                loops.vv(fa, fa, fb, len);
+                format.fromFloat(out + i, fa, len);
+            }
+        }
+
+        void vs(uint16_t *out, const uint16_t *a, uint16_t b, size_t n) const
+        {
+            float fa[HALF_BLOCK], fb;
+            format.toFloat(&fb, &b, 1);
+            for (size_t i = 0; i < n; i += HALF_BLOCK)
+            {
+                size_t len = std::min(HALF_BLOCK, n - i);
+                format.toFloat(fa, a + i, len);
+                loops.vs(fa, fa, fb, len);
+                format.fromFloat(out + i, fa, len);
+            }
+        }
+
+        void sv(uint16_t *out, uint16_t a, const uint16_t *b, size_t n) const
+        {
+            float fa, fb[HALF_BLOCK];
+            format.toFloat(&fa, &a, 1);
+            for (size_t i = 0; i < n; i += HALF_BLOCK)
+            {
+                size_t len = std::min(HALF_BLOCK, n - i);
+                format.toFloat(fb, b + i, len);
+                loops.sv(fb, fa, fb, len);
+                format.fromFloat(out + i, fb, len);
+            }
+        }
+    };
+
     class NativeElementWise : public CpuKernelWithoutConfig
     {
         template <typename T>
@@ -30,86 +85,263 @@ namespace infini
             return (T)(val0 / val1);
         }
 
-        template <typename T>
-        void doCompute(const Operator &_op, const RuntimeObj *context) const
+        template <typename T, T (*F)(T, T)>
+        static void vvLoop(T *out, const T *a, const T *b, size_t n)
         {
-            auto op = as<ElementWiseObj>(_op);
-            T *inptr0 = op->getInputs(0)->getRawDataPtr<T *>();
-            T *inptr1 = op->getInputs(1)->getRawDataPtr<T *>();
-            T *outptr = op->getOutput()->getRawDataPtr<T *>();
+            for (size_t i = 0; i < n; ++i)
+                out[i] = F(a[i], b[i]);
+        }
 
-            auto shapeA = op->getInputs(0)->getDims();
-            auto shapeB = op->getInputs(1)->getDims();
-            auto shapeC = op->getOutput()->getDims();
-            auto rank = op->getOutput()->getRank();
-            Shape a(rank, 1);
-            Shape b(rank, 1);
-            std::copy(shapeA.begin(), shapeA.end(),
-                      a.begin() + (rank - shapeA.size()));
-            std::copy(shapeB.begin(), shapeB.end(),
-                      b.begin() + (rank - shapeB.size()));
-            auto getStride = [&](const Shape &shape)
-            {
-                int p = 1;
-                Shape stride(rank);
-                for (auto i = rank; i > 0; --i)
-                {
-                    stride[i - 1] = p;
-                    p = p * shape[i - 1];
-                }
-                return stride;
-            };
-            Shape strideA = getStride(a);
-            Shape strideB = getStride(b);
+        template <typename T, T (*F)(T, T)>
+        static void vsLoop(T *out, const T *a, T b, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                out[i] = F(a[i], b);
+        }
 
-            auto n = op->getOutput()->size();
-            T (*_doCompute)
-            (T val0, T val1);
-            switch (op->getOpType().underlying())
+        template <typename T, T (*F)(T, T)>
+        static void svLoop(T *out, T a, const T *b, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                out[i] = F(a, b[i]);
+        }
+
+        template <typename T, T (*F)(T, T)>
+        static BinaryLoops<T> makeLoops()
+        {
+            return {vvLoop<T, F>, vsLoop<T, F>, svLoop<T, F>};
+        }
+
+        template <typename T>
+        static BinaryLoops<T> getLoops(OpType type)
+        {
+            if constexpr (std::is_same_v<T, float>)
+                return getFloatBinaryLoops(type);
+            switch (type.underlying())
             {
             case OpType::Add:
-                _doCompute = addCompute<T>;
-                break;
+                return makeLoops<T, addCompute<T>>();
             case OpType::Sub:
-                _doCompute = subCompute<T>;
-                break;
+                return makeLoops<T, subCompute<T>>();
             case OpType::Mul:
-                _doCompute = mulCompute<T>;
-                break;
+                return makeLoops<T, mulCompute<T>>();
             case OpType::Div:
-                _doCompute = divCompute<T>;
-                break;
+                return makeLoops<T, divCompute<T>>();
             default:
                 IT_TODO_HALT();
             }
+        }
 
-            for (size_t i = 0; i < n; ++i)
+        // One operand or both are strided views: walk the rows with their
+        // real strides, and gather the innermost dim into a dense block
+        // whenever it is neither contiguous nor broadcast.
+        template <typename T, typename Loops>
+        static KernelRoutine makeStridedRoutine(const Ref<ElementWiseObj> &op,
+                                                const RuntimeObj *context,
+                                                const Loops &loops)
+        {
+            T *inptr0 = op->getInputs(0)->getRawDataPtr<T *>();
+            T *inptr1 = op->getInputs(1)->getRawDataPtr<T *>();
+            T *outptr = op->getOutput()->getRawDataPtr<T *>();
+
+            Shape shapeC = op->getOutput()->getDims();
+            vector<Shape> strides{broadcast_strides(op->getInputs(0), shapeC),
+                                  broadcast_strides(op->getInputs(1), shapeC)};
+            collapse_strides(shapeC, strides);
+            const size_t cols = shapeC.back(),
+                         rows = op->getOutput()->size() / cols;
+            const size_t rowsPerChunk =
+                std::max<size_t>(1, ELEMENT_WISE_GRAIN / cols);
+            // only a single-element output broadcasts both operands
+            const int sa = strides[0].back(), sb = strides[1].back();
+            const bool vecA = sa != 0 || sb == 0, vecB = sb != 0;
+            return [=]
+            {
+                getThreadPool(context).parallel_for(
+                    0, rows, rowsPerChunk, [&](size_t begin, size_t end)
+                    {
+                        T bufA[STRIDED_BLOCK], bufB[STRIDED_BLOCK];
+                        auto run = [](T *buf, const T *src, int stride,
+                                      size_t len) -> const T *
+                        {
+                            if (stride <= 1)
+                                return src;
+                            for (size_t j = 0; j < len; ++j)
+                                buf[j] = src[j * stride];
+                            return buf;
+                        };
+                        BroadcastRowIterator it(shapeC, strides, begin);
+                        for (size_t r = begin; r < end; ++r, it.next())
+                        {
+                            const T *pa = inptr0 + it.offset(0);
+                            const T *pb = inptr1 + it.offset(1);
+                            for (size_t c = 0; c < cols; c += STRIDED_BLOCK)
+                            {
+                                size_t len = std::min(STRIDED_BLOCK, cols - c);
+                                T *out = outptr + r * cols + c;
+                                const T *a = run(bufA, pa + c * sa, sa, len);
+                                const T *b = run(bufB, pb + c * sb, sb, len);
+                                if (vecA && vecB)
+                                    loops.vv(out, a, b, len);
+                                else if (vecA)
+                                    loops.vs(out, a, *b, len);
+                                else
+                                    loops.sv(out, *a, b, len);
+                            }
+                        } });
+            };
+        }
+
+        // `Loops` is BinaryLoops<T> or, for 16-bit floats, HalfBinaryLoops.
+        // The broadcast analysis runs here, once; the routine only loops.
+        template <typename T, typename Loops>
+        static KernelRoutine makeRoutine(const Ref<ElementWiseObj> &op,
+                                         const RuntimeObj *context,
+                                         const Loops &loops)
+        {
+            if (!op->getInputs(0)->isContiguous() ||
+                !op->getInputs(1)->isContiguous())
+                return makeStridedRoutine<T>(op, context, loops);
+
+            T *inptr0 = op->getInputs(0)->getRawDataPtr<T *>();
+            T *inptr1 = op->getInputs(1)->getRawDataPtr<T *>();
+            T *outptr = op->getOutput()->getRawDataPtr<T *>();
+
+            Shape shapeC = op->getOutput()->getDims();
+            vector<Shape> shapes{op->getInputs(0)->getDims(),
+                                 op->getInputs(1)->getDims()};
+            collapse_broadcast(shapeC, shapes);
+            const Shape &a = shapes[0], &b = shapes[1];
+            const size_t n = op->getOutput()->size();
+
+            auto isScalar = [](const Shape &shape)
+            {
+                return std::all_of(shape.begin(), shape.end(),
+                                   [](int d)
+                                   { return d == 1; });
+            };
+            const bool fullA = a == shapeC, fullB = b == shapeC;
+
+            // identical shapes, or one operand is a scalar: one flat loop
+            if ((fullA || isScalar(a)) && (fullB || isScalar(b)))
+                return [=]
+                {
+                    getThreadPool(context).parallel_for(
+                        0, n, ELEMENT_WISE_GRAIN, [&](size_t begin, size_t end)
+                        {
+                            size_t len = end - begin;
+                            T *out = outptr + begin;
+                            if (fullA && fullB)
+                                loops.vv(out, inptr0 + begin, inptr1 + begin, len);
+                            else if (fullA)
+                                loops.vs(out, inptr0 + begin, *inptr1, len);
+                            else
+                                loops.sv(out, *inptr0, inptr1 + begin, len); });
+                };
+
+            const size_t cols = shapeC.back(), rows = n / cols;
+            const size_t rowsPerChunk =
+                std::max<size_t>(1, ELEMENT_WISE_GRAIN / cols);
+            // row broadcast [R, C] op [1, C] and column broadcast [R, C] op
+            // [R, 1], in either operand order
+            if (shapeC.size() == 2 && (fullA || fullB))
             {
-                auto shapeIndexC = locate_index(i, shapeC);
-                auto indexA = delocate_index(shapeIndexC, a, strideA);
-                auto indexB = delocate_index(shapeIndexC, b, strideB);
-                outptr[i] = _doCompute(inptr0[indexA], inptr1[indexB]);
+                const Shape &other = fullA ? b : a;
+                if (other[0] == 1 || other[1] == 1)
+                {
+                    bool row = other[0] == 1;
+                    return [=]
+                    {
+                        getThreadPool(context).parallel_for(
+                            0, rows, rowsPerChunk, [&](size_t begin, size_t end)
+                            {
+                                for (size_t r = begin; r < end; ++r)
+                                {
+                                    T *out = outptr + r * cols;
+                                    if (fullA && row)
+                                        loops.vv(out, inptr0 + r * cols, inptr1, cols);
+                                    else if (fullA)
+                                        loops.vs(out, inptr0 + r * cols, inptr1[r], cols);
+                                    else if (row)
+                                        loops.vv(out, inptr0, inptr1 + r * cols, cols);
+                                    else
+                                        loops.sv(out, inptr0[r], inptr1 + r * cols, cols);
+                                } });
+                    };
+                }
             }
+
+            // everything else: walk the rows with a stride iterator, the
+            // innermost dim is contiguous or broadcast for each operand
+            vector<Shape> strides{broadcast_strides(a, shapeC),
+                                  broadcast_strides(b, shapeC)};
+            const bool innerA = a.back() != 1, innerB = b.back() != 1;
+            return [=]
+            {
+                getThreadPool(context).parallel_for(
+                    0, rows, rowsPerChunk, [&](size_t begin, size_t end)
+                    {
+                        BroadcastRowIterator it(shapeC, strides, begin);
+                        for (size_t r = begin; r < end; ++r, it.next())
+                        {
+                            T *out = outptr + r * cols;
+                            const T *pa = inptr0 + it.offset(0);
+                            const T *pb = inptr1 + it.offset(1);
+                            // after collapsing, at least one operand spans the
+                            // innermost dim
+                            if (innerA && innerB)
+                                loops.vv(out, pa, pb, cols);
+                            else if (innerA)
+                                loops.vs(out, pa, *pb, cols);
+                            else
+                                loops.sv(out, *pa, pb, cols);
+                        } });
+            };
         }
 
-        void compute(const Operator &_op,
-                     const RuntimeObj *context) const override
+        template <typename T>
+        KernelRoutine doCompile(const Operator &_op,
+                                const RuntimeObj *context) const
+        {
+            auto op = as<ElementWiseObj>(_op);
+            return makeRoutine<T>(op, context, getLoops<T>(op->getOpType()));
+        }
+
+        KernelRoutine doCompileHalf(const Operator &_op,
+                                    const RuntimeObj *context) const
+        {
+            auto op = as<ElementWiseObj>(_op);
+            return makeRoutine<uint16_t>(
+                op, context,
+                HalfBinaryLoops{getLoops<float>(op->getOpType()),
+                                getHalfFormat(op->getDType())});
+        }
+
+        KernelRoutine compile(const Operator &_op,
+                              const RuntimeObj *context) const override
         {
 #define CASE(N) \
     case N:     \
-        doCompute<DT<N>::t>(_op, context)
+        return doCompile<DT<N>::t>(_op, context)
 
             int dataTypeIdx = _op->getDType().getIndex();
             switch (dataTypeIdx)
             {
-                CASE(1); // DataType::Float32
-                break;
+                CASE(1);  // DataType::Float32
                 CASE(12); // DataType::UInt32
-                break;
+            case 10:      // DataType::Float16
+            case 16:      // DataType::BFloat16
+                return doCompileHalf(_op, context);
             default:
                 IT_TODO_HALT();
             }
         }
+
+        void compute(const Operator &_op,
+                     const RuntimeObj *context) const override
+        {
+            compile(_op, context)();
+        }
     };
 
     REGISTER_KERNEL(Device::CPU, OpType::Add, NativeElementWise, "addNaive_CPU");
@@ -0,0 +1,265 @@
+#include "operators/fused_element_wise.h"
+#include "core/kernel.h"
+#include "utils/operator_utils.h"
+#include "utils/simd_loops.h"
+
+namespace infini
+{
+    // Below this many output elements the loops stay single-threaded.
+    constexpr size_t FUSED_ELEMENT_WISE_GRAIN = 1 << 15;
+
+    // Every register of a row is computed this many elements at a time, and
+    // registers share blocks once their last reader has run, so a chain keeps
+    // a few blocks live and its intermediates stay in L1.
+    constexpr size_t FUSED_BLOCK = HALF_BLOCK;
+
+    class NativeFusedElementwise : public CpuKernelWithoutConfig
+    {
+        // One instruction with its loops resolved for the host.
+        struct Step
+        {
+            ElementwiseInstr instr;
+            BinaryLoops<float> binary;
+            UnaryFloatLoop relu;
+            ClipFloatLoop clip;
+        };
+
+        // A register over one block of a row: a run of `len` values, or a
+        // single value broadcast along the row when `ptr` is null.
+        struct Operand
+        {
+            const float *ptr;
+            float scalar;
+        };
+
+        static void run(const Step &step, const Operand &lhs,
+                        const Operand &rhs, float *dst, size_t len,
+                        Operand &result)
+        {
+            // a step over scalars only produces a scalar
+            bool vector = lhs.ptr || rhs.ptr;
+            float *out = vector ? dst : &result.scalar;
+            size_t n = vector ? len : 1;
+            const float *a = lhs.ptr ? lhs.ptr : &lhs.scalar;
+            switch (step.instr.type.underlying())
+            {
+            case OpType::Relu:
+                step.relu(out, a, n);
+                break;
+            case OpType::Clip:
+                step.clip(out, a, n, step.instr.min, step.instr.max);
+                break;
+            default:
+                if (lhs.ptr && rhs.ptr)
+                    step.binary.vv(out, lhs.ptr, rhs.ptr, n);
+                else if (lhs.ptr)
+                    step.binary.vs(out, lhs.ptr, rhs.scalar, n);
+                else if (rhs.ptr)
+                    step.binary.sv(out, lhs.scalar, rhs.ptr, n);
+                else
+                    step.binary.vv(out, &lhs.scalar, &rhs.scalar, 1);
+            }
+            result.ptr = vector ? dst : nullptr;
+        }
+
+        // T is float, or uint16_t holding Float16 or BFloat16 data that is
+        // widened when loaded and narrowed when stored.
+        template <typename T>
+        static KernelRoutine makeRoutine(const Ref<FusedElementwiseObj> &op,
+                                         const RuntimeObj *context)
+        {
+            const size_t nInputs = op->numInputs();
+            vector<T *> inptrs;
+            for (auto &input : op->getInputs())
+                inptrs.push_back(input->getRawDataPtr<T *>());
+            T *outptr = op->getOutput()->getRawDataPtr<T *>();
+            HalfFormat format{};
+            if constexpr (!std::is_same_v<T, float>)
+                format = getHalfFormat(op->getDType());
+
+            vector<Step> steps;
+            for (auto &instr : op->getProgram())
+            {
+                Step step{instr, {}, getFloatReluLoop(), getFloatClipLoop()};
+                if (instr.rhs >= 0)
+                    step.binary = getFloatBinaryLoops(instr.type);
+                steps.push_back(step);
+            }
+
+            // inputs may be strided views; an innermost stride of 0 is a
+            // broadcast, of 1 a dense run, and anything else is gathered
+            Shape shapeC = op->getOutput()->getDims();
+            vector<Shape> strides;
+            for (auto &input : op->getInputs())
+                strides.push_back(broadcast_strides(input, shapeC));
+            collapse_strides(shapeC, strides);
+            vector<int> inner;
+            for (auto &stride : strides)
+                inner.push_back(stride.back());
+            const size_t n = op->getOutput()->size();
+            const size_t cols = shapeC.back(), rows = n / cols;
+            const size_t rowsPerChunk =
+                std::max<size_t>(1, FUSED_ELEMENT_WISE_GRAIN / cols);
+
+            // the step after which each register is no longer read; the
+            // result is read when the block is stored
+            const size_t nRegs = nInputs + steps.size();
+            vector<size_t> lastUse(nRegs, 0);
+            for (size_t s = 0; s < steps.size(); ++s)
+            {
+                lastUse[nInputs + s] = s;
+                lastUse[steps[s].instr.lhs] = s;
+                if (steps[s].instr.rhs >= 0)
+                    lastUse[steps[s].instr.rhs] = s;
+            }
+            lastUse.back() = steps.size();
+            // each input gets a block, and each step takes one its operands
+            // released or a new one; writing in place is safe element-wise
+            vector<size_t> block(nRegs), released;
+            size_t nBlocks = 0;
+            auto take = [&]
+            {
+                if (released.empty())
+                    return nBlocks++;
+                size_t b = released.back();
+                released.pop_back();
+                return b;
+            };
+            for (size_t i = 0; i < nInputs; ++i)
+                block[i] = take();
+            for (size_t s = 0; s < steps.size(); ++s)
+            {
+                auto &instr = steps[s].instr;
+                // a register read as both operands is released once
+                int rhs = instr.rhs == instr.lhs ? -1 : instr.rhs;
+                for (int reg : {instr.lhs, rhs})
+                    if (reg >= 0 && lastUse[reg] == s)
+                        released.push_back(block[reg]);
+                size_t reg = nInputs + s;
+                block[reg] = take();
+                if (lastUse[reg] == s)
+                    released.push_back(block[reg]);
+            }
+
+            return [=]
+            {
+                getThreadPool(context).parallel_for(
+                    0, rows, rowsPerChunk, [&](size_t begin, size_t end)
+                    {
+                        // per-thread scratch, grown once and then reused
+                        // by every chunk and run; with T = float, inputs
+                        // are read in place and the last step writes the
+                        // output directly
+                        thread_local vector<float> buffers;
+                        thread_local vector<Operand> regs;
+                        if (buffers.size() < nBlocks * FUSED_BLOCK)
+                            buffers.resize(nBlocks * FUSED_BLOCK);
+                        regs.resize(nRegs);
+                        // a strided half input is gathered before widening
+                        T gathered[FUSED_BLOCK];
+                        BroadcastRowIterator it(shapeC, strides, begin);
+                        for (size_t r = begin; r < end; ++r, it.next())
+                            for (size_t c = 0; c < cols; c += FUSED_BLOCK)
+                            {
+                                size_t len = std::min(FUSED_BLOCK, cols - c);
+                                T *out = outptr + r * cols + c;
+                                for (size_t i = 0; i < nInputs; ++i)
+                                {
+                                    const T *in = inptrs[i] + it.offset(i);
+                                    float *buf =
+                                        &buffers[block[i] * FUSED_BLOCK];
+                                    const int stride = inner[i];
+                                    if (stride == 0)
+                                    {
+                                        regs[i].ptr = nullptr;
+                                        if constexpr (std::is_same_v<T, float>)
+                                            regs[i].scalar = *in;
+                                        else
+                                            format.toFloat(&regs[i].scalar, in, 1);
+                                        continue;
+                                    }
+                                    in += c * stride;
+                                    if constexpr (std::is_same_v<T, float>)
+                                    {
+                                        if (stride == 1)
+                                        {
+                                            regs[i] = {in, 0.f};
+                                            continue;
+                                        }
+                                        for (size_t j = 0; j < len; ++j)
+                                            buf[j] = in[j * stride];
+                                    }
+                                    else
+                                    {
+                                        if (stride != 1)
+                                        {
+                                            for (size_t j = 0; j < len; ++j)
+                                                gathered[j] = in[j * stride];
+                                            in = gathered;
+                                        }
+                                        format.toFloat(buf, in, len);
+                                    }
+                                    regs[i] = {buf, 0.f};
+                                }
+                                for (size_t s = 0; s < steps.size(); ++s)
+                                {
+                                    size_t reg = nInputs + s;
+                                    float *dst =
+                                        &buffers[block[reg] * FUSED_BLOCK];
+                                    if constexpr (std::is_same_v<T, float>)
+                                        if (s + 1 == steps.size())
+                                            dst = out;
+                                    auto &instr = steps[s].instr;
+                                    run(steps[s], regs[instr.lhs],
+                                        instr.rhs >= 0 ? regs[instr.rhs]
+                                                       : Operand{},
+                                        dst, len, regs[reg]);
+                                }
+                                // a row of scalars is still written out
+                                // element by element
+                                Operand result = regs.back();
+                                float *last =
+                                    &buffers[block.back() * FUSED_BLOCK];
+                                if (!result.ptr)
+                                {
+                                    std::fill_n(last, len, result.scalar);
+                                    result.ptr = last;
+                                }
+                                if constexpr (std::is_same_v<T, float>)
+                                {
+                                    if (result.ptr != out)
+                                        std::copy_n(result.ptr, len, out);
+                                }
+                                else
+                                    format.fromFloat(out, result.ptr, len);
+                            } });
+            };
+        }
+
+        KernelRoutine compile(const Operator &_op,
+                              const RuntimeObj *context) const override
+        {
+            auto op = as<FusedElementwiseObj>(_op);
+            int dataTypeIdx = _op->getDType().getIndex();
+            switch (dataTypeIdx)
+            {
+            case 1: // DataType::Float32
+                return makeRoutine<float>(op, context);
+            case 10: // DataType::Float16
+            case 16: // DataType::BFloat16
+                return makeRoutine<uint16_t>(op, context);
+            default:
+                IT_TODO_HALT();
+            }
+        }
+
+        void compute(const Operator &_op,
+                     const RuntimeObj *context) const override
+        {
+            compile(_op, context)();
+        }
+    };
+
+    REGISTER_KERNEL(Device::CPU, OpType::FusedElementwise,
+                    NativeFusedElementwise, "FusedElementwise_CPU");
+}; // namespace infini
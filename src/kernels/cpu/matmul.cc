@@ -0,0 +1,403 @@
+#include "operators/matmul.h"
+#include "core/kernel.h"
+#include "utils/cpu_features.h"
+#include "utils/simd_loops.h"
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace infini {
+
+// Cache blocking of the packed GEMM: an MC x KC panel of A is kept in L2 and
+// a KC x NC panel of B in L2/L3, while the micro-kernel streams MR x KC and
+// KC x NR slivers of them through L1. MC and NC must be multiples of every
+// MR and NR below.
+constexpr int GEMM_MC = 144, GEMM_KC = 256, GEMM_NC = 256;
+constexpr int GEMM_MAX_MR = 6, GEMM_MAX_NR = 32;
+
+template <typename T> struct GemmMicroKernel {
+    int mr, nr;
+    // c[0:mr, 0:nr] (row stride ldc) = (accumulate ? c : 0) + a * b, where a
+    // is an mr-row sliver and b an nr-column sliver, both packed along k.
+    void (*run)(int kc, const T *a, const T *b, T *c, size_t ldc,
+                bool accumulate);
+};
+
+template <typename T, int MR, int NR>
+static void gemmMicroKernelRef(int kc, const T *a, const T *b, T *c,
+                               size_t ldc, bool accumulate) {
+    T acc[MR][NR] = {};
+    for (int p = 0; p < kc; ++p, a += MR, b += NR)
+        for (int r = 0; r < MR; ++r)
+#pragma omp simd
+            for (int j = 0; j < NR; ++j)
+                acc[r][j] += a[r] * b[j];
+    for (int r = 0; r < MR; ++r)
+        for (int j = 0; j < NR; ++j)
+            c[r * ldc + j] = accumulate ? c[r * ldc + j] + acc[r][j] : acc[r][j];
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2,fma"))) static void
+gemmMicroKernelAvx2(int kc, const float *a, const float *b, float *c,
+                    size_t ldc, bool accumulate) {
+    // 6 x 16 tile: 12 ymm accumulators, 2 for B and 1 for the A broadcast
+    __m256 acc[6][2];
+#pragma GCC unroll 6
+    for (int r = 0; r < 6; ++r)
+        acc[r][0] = acc[r][1] = _mm256_setzero_ps();
+    for (int p = 0; p < kc; ++p, a += 6, b += 16) {
+        __m256 b0 = _mm256_loadu_ps(b), b1 = _mm256_loadu_ps(b + 8);
+#pragma GCC unroll 6
+        for (int r = 0; r < 6; ++r) {
+            __m256 ar = _mm256_broadcast_ss(a + r);
+            acc[r][0] = _mm256_fmadd_ps(ar, b0, acc[r][0]);
+            acc[r][1] = _mm256_fmadd_ps(ar, b1, acc[r][1]);
+        }
+    }
+#pragma GCC unroll 6
+    for (int r = 0; r < 6; ++r) {
+        float *cr = c + r * ldc;
+        if (accumulate) {
+            acc[r][0] = _mm256_add_ps(acc[r][0], _mm256_loadu_ps(cr));
+            acc[r][1] = _mm256_add_ps(acc[r][1], _mm256_loadu_ps(cr + 8));
+        }
+        _mm256_storeu_ps(cr, acc[r][0]);
+        _mm256_storeu_ps(cr + 8, acc[r][1]);
+    }
+}
+
+__attribute__((target("avx512f,fma"))) static void
+gemmMicroKernelAvx512(int kc, const float *a, const float *b, float *c,
+                      size_t ldc, bool accumulate) {
+    // 6 x 32 tile: 12 zmm accumulators, 2 for B and 1 for the A broadcast
+    __m512 acc[6][2];
+#pragma GCC unroll 6
+    for (int r = 0; r < 6; ++r)
+        acc[r][0] = acc[r][1] = _mm512_setzero_ps();
+    for (int p = 0; p < kc; ++p, a += 6, b += 32) {
+        __m512 b0 = _mm512_loadu_ps(b), b1 = _mm512_loadu_ps(b + 16);
+#pragma GCC unroll 6
+        for (int r = 0; r < 6; ++r) {
+            __m512 ar = _mm512_set1_ps(a[r]);
+            acc[r][0] = _mm512_fmadd_ps(ar, b0, acc[r][0]);
+            acc[r][1] = _mm512_fmadd_ps(ar, b1, acc[r][1]);
+        }
+    }
+#pragma GCC unroll 6
+    for (int r = 0; r < 6; ++r) {
+        float *cr = c + r * ldc;
+        if (accumulate) {
+            acc[r][0] = _mm512_add_ps(acc[r][0], _mm512_loadu_ps(cr));
+            acc[r][1] = _mm512_add_ps(acc[r][1], _mm512_loadu_ps(cr + 16));
+        }
+        _mm512_storeu_ps(cr, acc[r][0]);
+        _mm512_storeu_ps(cr + 16, acc[r][1]);
+    }
+}
+#endif
+
+template <typename T> static GemmMicroKernel<T> selectGemmMicroKernel() {
+    return {4, 8, gemmMicroKernelRef<T, 4, 8>};
+}
+
+template <> GemmMicroKernel<float> selectGemmMicroKernel<float>() {
+#if defined(__x86_64__)
+    switch (getSimdLevel()) {
+    case SimdLevel::AVX512:
+        return {6, 32, gemmMicroKernelAvx512};
+    case SimdLevel::AVX2:
+        return {6, 16, gemmMicroKernelAvx2};
+    default:
+        break;
+    }
+#endif
+    return {4, 8, gemmMicroKernelRef<float, 4, 8>};
+}
+
+// Copies src[0:rows, 0:cols] (strides rs, cs) into slivers of `width` rows,
+// each stored k-major as the micro-kernel reads it. Rows past the edge are
+// zero-padded so that edge tiles can run the full micro-kernel.
+template <typename T>
+static void packPanel(const T *src, size_t rs, size_t cs, int rows, int cols,
+                      int width, T *dst) {
+    for (int i0 = 0; i0 < rows; i0 += width) {
+        int w = std::min(width, rows - i0);
+        for (int p = 0; p < cols; ++p, dst += width) {
+            const T *s = src + i0 * rs + p * cs;
+            for (int r = 0; r < w; ++r)
+                dst[r] = s[r * rs];
+            for (int r = w; r < width; ++r)
+                dst[r] = T(0);
+        }
+    }
+}
+
+// packPanel for 16-bit float sources, widened to Float32 on the way. One of
+// rs and cs is 1, and the conversions always run along that contiguous
+// direction; `cols` is at most GEMM_KC.
+static void packHalfPanel(const uint16_t *src, size_t rs, size_t cs, int rows,
+                          int cols, int width, float *dst,
+                          const HalfFormat &format) {
+    float row[GEMM_KC];
+    for (int i0 = 0; i0 < rows; i0 += width, dst += (size_t)width * cols) {
+        int w = std::min(width, rows - i0);
+        if (rs == 1) {
+            for (int p = 0; p < cols; ++p) {
+                format.toFloat(dst + p * width, src + i0 + p * cs, w);
+                std::fill(dst + p * width + w, dst + (p + 1) * width, 0.f);
+            }
+            continue;
+        }
+        for (int r = 0; r < width; ++r) {
+            if (r < w)
+                format.toFloat(row, src + (i0 + r) * rs, cols);
+            for (int p = 0; p < cols; ++p)
+                dst[p * width + r] = r < w ? row[p] : 0.f;
+        }
+    }
+}
+
+class NativeMatmul : public CpuKernelWithoutConfig {
+    // Computes in T the product of operands stored as S. When they differ,
+    // S is a 16-bit float type described by `format`, and each output tile
+    // is accumulated over all of K in Float32 before it is narrowed.
+    template <typename T, typename S>
+    static KernelRoutine gemm(const Ref<MatmulObj> &op,
+                              const RuntimeObj *context, HalfFormat format) {
+        constexpr bool half = !std::is_same_v<T, S>;
+        static const GemmMicroKernel<T> ukr = selectGemmMicroKernel<T>();
+        const S *A = op->getInputs(0)->getRawDataPtr<S *>();
+        const S *B = op->getInputs(1)->getRawDataPtr<S *>();
+        S *C = op->getOutput()->getRawDataPtr<S *>();
+        const int M = op->getM(), N = op->getN(), K = op->getK();
+
+        // the epilogue, applied to each micro tile as its last K panel lands
+        const S *bias =
+            op->getBias() ? op->getBias()->getRawDataPtr<S *>() : nullptr;
+        const S *residual = op->getResidual()
+                                ? op->getResidual()->getRawDataPtr<S *>()
+                                : nullptr;
+        const bool hasMin = op->getMin().has_value();
+        const bool hasMax = op->getMax().has_value();
+        const T lo = hasMin ? T(*op->getMin()) : T(0);
+        const T hi = hasMax ? T(*op->getMax()) : T(0);
+        const bool epilogue = op->hasEpilogue();
+
+        // A(i, p) = A[i * rsA + p * csA] and B(p, j) = B[p * rsB + j * csB]
+        const size_t rsA = op->getTransA() ? 1 : K;
+        const size_t csA = op->getTransA() ? M : 1;
+        const size_t rsB = op->getTransB() ? 1 : N;
+        const size_t csB = op->getTransB() ? K : 1;
+
+        // Offsets of A and B for each output batch, with broadcast batch
+        // dimensions contributing a zero stride.
+        auto shapeA = op->getInputs(0)->getDims();
+        auto shapeB = op->getInputs(1)->getDims();
+        auto shapeC = op->getOutput()->getDims();
+        int batchRank = shapeC.size() - 2;
+        vector<size_t> offsetA{0}, offsetB{0};
+        size_t strideA = (size_t)M * K, strideB = (size_t)K * N;
+        for (int d = batchRank - 1; d >= 0; --d) {
+            size_t n = offsetA.size();
+            vector<size_t> nextA, nextB;
+            nextA.reserve(n * shapeC[d]);
+            nextB.reserve(n * shapeC[d]);
+            for (int i = 0; i < shapeC[d]; ++i)
+                for (size_t j = 0; j < n; ++j) {
+                    nextA.emplace_back(offsetA[j] +
+                                       (shapeA[d] == 1 ? 0 : i * strideA));
+                    nextB.emplace_back(offsetB[j] +
+                                       (shapeB[d] == 1 ? 0 : i * strideB));
+                }
+            offsetA = std::move(nextA);
+            offsetB = std::move(nextB);
+            strideA *= shapeA[d];
+            strideB *= shapeB[d];
+        }
+
+        return [=, offsetA = std::move(offsetA),
+                offsetB = std::move(offsetB)] {
+            const int batch = offsetA.size();
+            const int mTiles = (M + GEMM_MC - 1) / GEMM_MC;
+            const int nTiles = (N + GEMM_NC - 1) / GEMM_NC;
+            const int nWork = batch * mTiles * nTiles;
+            const int mr = ukr.mr, nr = ukr.nr;
+
+            // a 16-bit bias is widened once per run
+            vector<T> biasWide;
+            const T *biasT = nullptr;
+            if constexpr (half) {
+                if (bias) {
+                    biasWide.resize(N);
+                    format.toFloat(biasWide.data(), bias, N);
+                    biasT = biasWide.data();
+                }
+            } else
+                biasT = bias;
+
+            // Finishes ct[0:rows, 0:cols] (row stride ldc), the block of
+            // the output of batch b starting at row i and column j.
+            auto finish = [&](T *ct, size_t ldc, int b, int i, int j,
+                              int rows, int cols) {
+                for (int r = 0; r < rows; ++r) {
+                    T *row = ct + r * ldc;
+                    if (biasT) {
+                        const T *br = biasT + j;
+#pragma omp simd
+                        for (int c = 0; c < cols; ++c)
+                            row[c] += br[c];
+                    }
+                    if (residual) {
+                        const S *res =
+                            residual + ((size_t)b * M + i + r) * N + j;
+                        if constexpr (half) {
+                            float wide[GEMM_MAX_NR];
+                            format.toFloat(wide, res, cols);
+#pragma omp simd
+                            for (int c = 0; c < cols; ++c)
+                                row[c] += wide[c];
+                        } else {
+#pragma omp simd
+                            for (int c = 0; c < cols; ++c)
+                                row[c] += res[c];
+                        }
+                    }
+                    if (hasMin)
+#pragma omp simd
+                        for (int c = 0; c < cols; ++c)
+                            row[c] = std::max(row[c], lo);
+                    if (hasMax)
+#pragma omp simd
+                        for (int c = 0; c < cols; ++c)
+                            row[c] = std::min(row[c], hi);
+                }
+            };
+
+            // tiny products run inline, the others one tile per task
+            const int grain = (size_t)M * N * K > 32768 ? 1 : nWork;
+            getThreadPool(context).parallel_for(0, nWork, grain, [&](size_t begin,
+                                                                     size_t end) {
+                vector<T> packA((size_t)GEMM_MC * GEMM_KC);
+                vector<T> packB((size_t)GEMM_KC * GEMM_NC);
+                vector<T> accC(half ? (size_t)GEMM_MC * GEMM_NC : 0);
+                T tile[GEMM_MAX_MR * GEMM_MAX_NR];
+                for (int w = begin; w < (int)end; ++w) {
+                    int b = w / (mTiles * nTiles);
+                    int ic = w / nTiles % mTiles * GEMM_MC;
+                    int jc = w % nTiles * GEMM_NC;
+                    int mc = std::min(GEMM_MC, M - ic);
+                    int nc = std::min(GEMM_NC, N - jc);
+                    const S *a = A + offsetA[b];
+                    const S *bb = B + offsetB[b];
+                    S *c = C + (size_t)b * M * N + (size_t)ic * N + jc;
+                    // the micro-kernels write to cOut, with row stride ldc
+                    T *cOut;
+                    size_t ldc;
+                    if constexpr (half)
+                        cOut = accC.data(), ldc = nc;
+                    else
+                        cOut = c, ldc = N;
+                    // an empty sum: no panel ever lands, the tile is zero
+                    // plus the epilogue
+                    if (K == 0) {
+                        for (int r = 0; r < mc; ++r)
+                            std::fill_n(cOut + (size_t)r * ldc, nc, T(0));
+                        if (epilogue)
+                            for (int jr = 0; jr < nc; jr += nr)
+                                for (int ir = 0; ir < mc; ir += mr)
+                                    finish(cOut + (size_t)ir * ldc + jr, ldc,
+                                           b, ic + ir, jc + jr,
+                                           std::min(mr, mc - ir),
+                                           std::min(nr, nc - jr));
+                    }
+                    for (int pc = 0; pc < K; pc += GEMM_KC) {
+                        int kc = std::min(GEMM_KC, K - pc);
+                        bool accumulate = pc > 0;
+                        bool last = epilogue && pc + kc >= K;
+                        if constexpr (half) {
+                            packHalfPanel(bb + pc * rsB + jc * csB, csB, rsB,
+                                          nc, kc, nr, packB.data(), format);
+                            packHalfPanel(a + ic * rsA + pc * csA, rsA, csA,
+                                          mc, kc, mr, packA.data(), format);
+                        } else {
+                            packPanel(bb + pc * rsB + jc * csB, csB, rsB, nc,
+                                      kc, nr, packB.data());
+                            packPanel(a + ic * rsA + pc * csA, rsA, csA, mc,
+                                      kc, mr, packA.data());
+                        }
+                        for (int jr = 0; jr < nc; jr += nr) {
+                            int nrEff = std::min(nr, nc - jr);
+                            const T *bp = packB.data() + (size_t)jr * kc;
+                            for (int ir = 0; ir < mc; ir += mr) {
+                                int mrEff = std::min(mr, mc - ir);
+                                const T *ap = packA.data() + (size_t)ir * kc;
+                                T *ct = cOut + (size_t)ir * ldc + jr;
+                                if (mrEff == mr && nrEff == nr) {
+                                    ukr.run(kc, ap, bp, ct, ldc, accumulate);
+                                    if (last)
+                                        finish(ct, ldc, b, ic + ir, jc + jr,
+                                               mr, nr);
+                                    continue;
+                                }
+                                ukr.run(kc, ap, bp, tile, nr, false);
+                                for (int r = 0; r < mrEff; ++r)
+                                    for (int j = 0; j < nrEff; ++j)
+                                        ct[r * ldc + j] =
+                                            accumulate ? ct[r * ldc + j] +
+                                                             tile[r * nr + j]
+                                                       : tile[r * nr + j];
+                                if (last)
+                                    finish(ct, ldc, b, ic + ir, jc + jr,
+                                           mrEff, nrEff);
+                            }
+                        }
+                    }
+                    if constexpr (half)
+                        for (int r = 0; r < mc; ++r)
+                            format.fromFloat(c + (size_t)r * N,
+                                              accC.data() + (size_t)r * nc, nc);
+                }
+            });
+        };
+    }
+
+    template <typename T>
+    KernelRoutine doCompile(const Operator &_op,
+                            const RuntimeObj *context) const {
+        return gemm<T, T>(as<MatmulObj>(_op), context, {});
+    }
+
+    KernelRoutine doCompileHalf(const Operator &_op,
+                                const RuntimeObj *context) const {
+        return gemm<float, uint16_t>(as<MatmulObj>(_op), context,
+                                     getHalfFormat(_op->getDType()));
+    }
+
+    KernelRoutine compile(const Operator &_op,
+                          const RuntimeObj *context) const override {
+#define CASE(N)                                                                \
+    case N:                                                                    \
+        return doCompile<DT<N>::t>(_op, context)
+
+        int dataTypeIdx = _op->getDType().getIndex();
+        switch (dataTypeIdx) {
+            CASE(1);  // DataType::Float32
+            CASE(12); // DataType::UInt32
+        case 10:      // DataType::Float16
+        case 16:      // DataType::BFloat16
+            return doCompileHalf(_op, context);
+        default:
+            IT_TODO_HALT();
+        }
+    }
+
+    void compute(const Operator &_op,
+                 const RuntimeObj *context) const override {
+        compile(_op, context)();
+    }
+};
+
+REGISTER_KERNEL(Device::CPU, OpType::MatMul, NativeMatmul, "Matmul_CPU");
+
+} // namespace infini
@@ -1,57 +1,325 @@
 #include "operators/transpose.h"
 #include "core/kernel.h"
+#include "utils/cpu_features.h"
+#include "utils/operator_utils.h"
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 namespace infini {
 
-inline Shape idx2Pos(const Shape &shape, size_t idx) {
-    Shape pos = Shape(shape.size(), 0);
-    auto rest = idx, curDimId = shape.size() - 1;
-    while (rest > 0) {
-        pos[curDimId] = rest % shape[curDimId];
-        rest /= shape[curDimId];
-        curDimId--;
+// Side of the square tiles of the 2-D transpose, sized so that one input
+// and one output tile of 4-byte elements fit in L1 together.
+constexpr int TRANSPOSE_TILE = 64;
+// Below this many elements the kernel stays single-threaded.
+constexpr size_t TRANSPOSE_GRAIN = 1 << 15;
+
+// Drops unit dims and merges input dims that stay adjacent under `perm`,
+// e.g. [N, H, W, C] with perm [0, 3, 1, 2] becomes [N, H*W, C] with perm
+// [0, 2, 1].
+static void mergeTransposeDims(Shape &shape, vector<int> &perm) {
+    vector<int> newIndex(shape.size(), -1);
+    Shape kept;
+    for (size_t d = 0; d < shape.size(); ++d)
+        if (shape[d] != 1) {
+            newIndex[d] = kept.size();
+            kept.emplace_back(shape[d]);
+        }
+    // runs of consecutive input dims, in output order
+    vector<pair<int, int>> groups;
+    for (int d : perm) {
+        int i = newIndex[d];
+        if (i < 0)
+            continue;
+        if (!groups.empty() && groups.back().second + 1 == i)
+            groups.back().second = i;
+        else
+            groups.emplace_back(i, i);
+    }
+    vector<int> order(groups.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int x, int y) {
+        return groups[x].first < groups[y].first;
+    });
+    shape.assign(groups.size(), 1);
+    perm.assign(groups.size(), 0);
+    for (size_t k = 0; k < order.size(); ++k) {
+        auto [first, last] = groups[order[k]];
+        for (int d = first; d <= last; ++d)
+            shape[k] *= kept[d];
+        perm[order[k]] = k;
+    }
+    if (shape.empty()) {
+        shape = {1};
+        perm = {0};
     }
-    return pos;
+}
+
+// Transposes a full square block: out[j][i] = in[i][j].
+template <typename T>
+using TransposeBlock = void (*)(const T *in, size_t ldIn, T *out,
+                                size_t ldOut);
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) static void
+transposeBlock4x4(const uint32_t *in, size_t ldIn, uint32_t *out,
+                  size_t ldOut) {
+    auto src = reinterpret_cast<const float *>(in);
+    auto dst = reinterpret_cast<float *>(out);
+    __m128 r0 = _mm_loadu_ps(src), r1 = _mm_loadu_ps(src + ldIn),
+           r2 = _mm_loadu_ps(src + 2 * ldIn), r3 = _mm_loadu_ps(src + 3 * ldIn);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(dst, r0);
+    _mm_storeu_ps(dst + ldOut, r1);
+    _mm_storeu_ps(dst + 2 * ldOut, r2);
+    _mm_storeu_ps(dst + 3 * ldOut, r3);
+}
+
+__attribute__((target("avx2"))) static void
+transposeBlock8x8(const uint32_t *in, size_t ldIn, uint32_t *out,
+                  size_t ldOut) {
+    auto src = reinterpret_cast<const float *>(in);
+    auto dst = reinterpret_cast<float *>(out);
+    __m256 r[8], t[8];
+    for (int i = 0; i < 8; ++i)
+        r[i] = _mm256_loadu_ps(src + i * ldIn);
+    for (int i = 0; i < 8; i += 2) {
+        t[i] = _mm256_unpacklo_ps(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_ps(r[i], r[i + 1]);
+    }
+    for (int i = 0; i < 8; i += 4) {
+        r[i] = _mm256_shuffle_ps(t[i], t[i + 2], 0x44);
+        r[i + 1] = _mm256_shuffle_ps(t[i], t[i + 2], 0xEE);
+        r[i + 2] = _mm256_shuffle_ps(t[i + 1], t[i + 3], 0x44);
+        r[i + 3] = _mm256_shuffle_ps(t[i + 1], t[i + 3], 0xEE);
+    }
+    for (int i = 0; i < 4; ++i) {
+        t[i] = _mm256_permute2f128_ps(r[i], r[i + 4], 0x20);
+        t[i + 4] = _mm256_permute2f128_ps(r[i], r[i + 4], 0x31);
+    }
+    for (int i = 0; i < 8; ++i)
+        _mm256_storeu_ps(dst + i * ldOut, t[i]);
+}
+
+__attribute__((target("sse4.2"))) static void
+transposeBlock8x8U16(const uint16_t *in, size_t ldIn, uint16_t *out,
+                     size_t ldOut) {
+    __m128i r[8], t[8];
+    for (int i = 0; i < 8; ++i)
+        r[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i * ldIn));
+    // interleave 16-bit, then 32-bit pairs, then 64-bit halves
+    for (int i = 0; i < 8; i += 2) {
+        t[i] = _mm_unpacklo_epi16(r[i], r[i + 1]);
+        t[i + 1] = _mm_unpackhi_epi16(r[i], r[i + 1]);
+    }
+    for (int i = 0; i < 8; i += 4) {
+        r[i] = _mm_unpacklo_epi32(t[i], t[i + 2]);
+        r[i + 1] = _mm_unpackhi_epi32(t[i], t[i + 2]);
+        r[i + 2] = _mm_unpacklo_epi32(t[i + 1], t[i + 3]);
+        r[i + 3] = _mm_unpackhi_epi32(t[i + 1], t[i + 3]);
+    }
+    for (int i = 0; i < 4; ++i) {
+        t[2 * i] = _mm_unpacklo_epi64(r[i], r[i + 4]);
+        t[2 * i + 1] = _mm_unpackhi_epi64(r[i], r[i + 4]);
+    }
+    for (int i = 0; i < 8; ++i)
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * ldOut), t[i]);
+}
+#endif
+
+template <typename T, int B>
+static void transposeBlockRef(const T *in, size_t ldIn, T *out, size_t ldOut) {
+    for (int i = 0; i < B; ++i)
+        for (int j = 0; j < B; ++j)
+            out[j * ldOut + i] = in[i * ldIn + j];
+}
+
+template <typename T> static pair<int, TransposeBlock<T>> selectBlock() {
+    return {8, transposeBlockRef<T, 8>};
+}
+
+template <> pair<int, TransposeBlock<uint32_t>> selectBlock<uint32_t>() {
+#if defined(__x86_64__)
+    auto level = getSimdLevel();
+    if (level >= SimdLevel::AVX2)
+        return {8, transposeBlock8x8};
+    if (level >= SimdLevel::SSE42)
+        return {4, transposeBlock4x4};
+#endif
+    return {8, transposeBlockRef<uint32_t, 8>};
+}
+
+template <> pair<int, TransposeBlock<uint16_t>> selectBlock<uint16_t>() {
+#if defined(__x86_64__)
+    if (getSimdLevel() >= SimdLevel::SSE42)
+        return {8, transposeBlock8x8U16};
+#endif
+    return {8, transposeBlockRef<uint16_t, 8>};
 }
 
 class NaiveTranspose : public CpuKernelWithoutConfig {
+    // Transposes rows [r0, r1) x cols [c0, c1) of a rows x cols matrix.
     template <typename T>
-    void doCompute(const Operator &_op, const RuntimeObj *context) const {
-        auto op = as<TransposeObj>(_op);
-        auto inputs = op->getInputs(), outputs = op->getOutputs();
-        const auto &inDim = inputs[0]->getDims();
-        const auto &perm = op->getPermute();
-
-        size_t inSize = inputs[0]->size();
-        auto inPtr = inputs[0]->getRawDataPtr<T *>(),
-             outPtr = outputs[0]->getRawDataPtr<T *>();
-        // #pragma omp parallel for
-        for (size_t inIdx = 0; inIdx < inSize; ++inIdx) {
-            auto posInput = idx2Pos(inDim, inIdx);
-            int outIdx = 0;
-            for (size_t j = 0, jEnd = perm.size(); j < jEnd; ++j) {
-                outIdx = outIdx * inDim[perm[j]] + posInput[perm[j]];
+    static void transposeTile(const T *src, T *dst, size_t rows, size_t cols,
+                              size_t r0, size_t r1, size_t c0, size_t c1,
+                              size_t bs, TransposeBlock<T> block) {
+        size_t r = r0;
+        for (; r + bs <= r1; r += bs) {
+            size_t c = c0;
+            for (; c + bs <= c1; c += bs)
+                block(src + r * cols + c, cols, dst + c * rows + r, rows);
+            for (; c < c1; ++c)
+                for (size_t i = r; i < r + bs; ++i)
+                    dst[c * rows + i] = src[i * cols + c];
+        }
+        for (; r < r1; ++r)
+            for (size_t c = c0; c < c1; ++c)
+                dst[c * rows + r] = src[r * cols + c];
+    }
+
+    // out[b][c][r] = in[b][r][c], tiled and parallel over all the tiles
+    template <typename T>
+    static void transpose2D(ThreadPool &pool, const T *in, T *out,
+                            size_t batch, size_t rows, size_t cols) {
+        static const auto selected = selectBlock<T>();
+        const size_t bs = selected.first;
+        const auto block = selected.second;
+        const size_t rowTiles = (rows + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE;
+        const size_t colTiles = (cols + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE;
+        const size_t nWork = batch * rowTiles * colTiles;
+        const size_t grain = std::max<size_t>(
+            1, TRANSPOSE_GRAIN / (TRANSPOSE_TILE * TRANSPOSE_TILE));
+        pool.parallel_for(0, nWork, grain, [&](size_t begin, size_t end) {
+            for (size_t w = begin; w < end; ++w) {
+                size_t b = w / (rowTiles * colTiles);
+                size_t r0 = w / colTiles % rowTiles * TRANSPOSE_TILE;
+                size_t c0 = w % colTiles * TRANSPOSE_TILE;
+                size_t r1 = std::min(rows, r0 + TRANSPOSE_TILE);
+                size_t c1 = std::min(cols, c0 + TRANSPOSE_TILE);
+                transposeTile(in + b * rows * cols, out + b * rows * cols,
+                              rows, cols, r0, r1, c0, c1, bs, block);
             }
-            outPtr[outIdx] = inPtr[inIdx];
+        });
+    }
+
+    // Gathers each row of the dense output from the input elements at
+    // `stride` apart along every dim of `outDim`.
+    template <typename T>
+    static KernelRoutine gatherRows(const RuntimeObj *context, const T *inPtr,
+                                    T *outPtr, const Shape &outDim,
+                                    const Shape &stride) {
+        const size_t cols = outDim.back();
+        const size_t rows = std::accumulate(outDim.begin(), outDim.end(),
+                                            size_t(1), std::multiplies{}) /
+                            cols;
+        const size_t innerStride = stride.back();
+        const size_t rowsPerChunk =
+            std::max<size_t>(1, TRANSPOSE_GRAIN / cols);
+        const vector<Shape> strides{stride};
+        return [=] {
+            getThreadPool(context).parallel_for(
+                0, rows, rowsPerChunk, [&](size_t begin, size_t end) {
+                    BroadcastRowIterator it(outDim, strides, begin);
+                    for (size_t r = begin; r < end; ++r, it.next()) {
+                        const T *src = inPtr + it.offset(0);
+                        T *dst = outPtr + r * cols;
+                        if (innerStride == 1) {
+                            std::memcpy(dst, src, cols * sizeof(T));
+                            continue;
+                        }
+                        for (size_t j = 0; j < cols; ++j)
+                            dst[j] = src[j * innerStride];
+                    }
+                });
+        };
+    }
+
+    template <typename T>
+    KernelRoutine doCompile(const Operator &_op,
+                            const RuntimeObj *context) const {
+        auto op = as<TransposeObj>(_op);
+        auto input = op->getInputs(0), output = op->getOutput();
+        vector<int> perm = op->getPermute();
+        auto inPtr = input->getRawDataPtr<T *>(),
+             outPtr = output->getRawDataPtr<T *>();
+        // the output is a strided view of the input, or empty: nothing to
+        // move
+        if (output->getDataBlob() == input->getDataBlob() ||
+            input->size() == 0)
+            return [] {};
+        if (!input->isContiguous()) {
+            Shape outDim = output->getDims(), inStride = input->getStrides();
+            vector<Shape> strides{Shape(perm.size())};
+            for (size_t d = 0; d < perm.size(); ++d)
+                strides[0][d] = inStride[perm[d]];
+            collapse_strides(outDim, strides);
+            return gatherRows(context, inPtr, outPtr, outDim, strides[0]);
         }
+
+        Shape inDim = input->getDims();
+        mergeTransposeDims(inDim, perm);
+        size_t inSize = input->size();
+        const int rank = inDim.size();
+        if (rank == 1)
+            return [=] { std::memcpy(outPtr, inPtr, inSize * sizeof(T)); };
+
+        // swap of the last two (merged) dims, with a leading batch dim at
+        // most since merging folds an identity prefix into one dim
+        if (perm[rank - 1] == rank - 2 && perm[rank - 2] == rank - 1 &&
+            (rank == 2 || (rank == 3 && perm[0] == 0))) {
+            size_t rows = inDim[rank - 2], cols = inDim[rank - 1];
+            size_t batch = inSize / (rows * cols);
+            // the in-register blocks only move bits, so 4-byte types share
+            // the uint32_t path
+            if constexpr (sizeof(T) == sizeof(uint32_t))
+                return [=] {
+                    transpose2D(getThreadPool(context),
+                                reinterpret_cast<const uint32_t *>(inPtr),
+                                reinterpret_cast<uint32_t *>(outPtr), batch,
+                                rows, cols);
+                };
+            else
+                return [=] {
+                    transpose2D(getThreadPool(context), inPtr, outPtr, batch,
+                                rows, cols);
+                };
+        }
+
+        // general permutation: gather each output row with the input
+        // strides of the permuted dims
+        Shape inStride(rank), outDim(rank), stride(rank);
+        for (int d = rank - 1, p = 1; d >= 0; --d) {
+            inStride[d] = p;
+            p *= inDim[d];
+        }
+        for (int d = 0; d < rank; ++d) {
+            outDim[d] = inDim[perm[d]];
+            stride[d] = inStride[perm[d]];
+        }
+        return gatherRows(context, inPtr, outPtr, outDim, stride);
     }
 
-    void compute(const Operator &_op,
-                 const RuntimeObj *context) const override {
+    KernelRoutine compile(const Operator &_op,
+                          const RuntimeObj *context) const override {
 #define CASE(N)                                                                \
     case N:                                                                    \
-        doCompute<DT<N>::t>(_op, context)
+        return doCompile<DT<N>::t>(_op, context)
 
         int dataTypeIdx = _op->getDType().getIndex();
         switch (dataTypeIdx) {
-            CASE(1); // DataType::Float32
-            break;
+            CASE(1);  // DataType::Float32
             CASE(12); // DataType::UInt32
-            break;
+            CASE(10); // DataType::Float16
+            CASE(16); // DataType::BFloat16
         default:
             IT_TODO_HALT();
         }
     }
+
+    void compute(const Operator &_op,
+                 const RuntimeObj *context) const override {
+        compile(_op, context)();
+    }
 };
 
 REGISTER_KERNEL(Device::CPU, OpType::Transpose, NaiveTranspose,
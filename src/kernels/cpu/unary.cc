@@ -1,8 +1,36 @@
 #include "operators/unary.h"
 #include "core/kernel.h"
+#include "utils/simd_loops.h"
 
 namespace infini
 {
+    // Elements per parallel chunk; smaller tensors stay single-threaded.
+    constexpr size_t UNARY_GRAIN = 1 << 15;
+
+    // Runs loop(offset, len) over [0, n) in chunks of at least UNARY_GRAIN.
+    template <typename F>
+    static void forEachChunk(ThreadPool &pool, size_t n, F &&loop)
+    {
+        pool.parallel_for(0, n, UNARY_GRAIN, [&](size_t begin, size_t end)
+                          { loop(begin, end - begin); });
+    }
+
+    // Runs loop(out, in, len) over 16-bit float data widened to Float32,
+    // HALF_BLOCK elements at a time.
+    template <typename F>
+    static void halfLoop(const HalfFormat &format, uint16_t *out,
+                         const uint16_t *in, size_t n, F &&loop)
+    {
+        float buf[HALF_BLOCK];
+        for (size_t i = 0; i < n; i += HALF_BLOCK)
+        {
+            size_t len = std::min(HALF_BLOCK, n - i);
+            format.toFloat(buf, in + i, len);
+            loop(buf, buf, len);
+            format.fromFloat(out + i, buf, len);
+        }
+    }
+
     class NativeUnary : public CpuKernelWithoutConfig
     {
         template <typename T>
@@ -11,57 +39,102 @@ namespace infini
             return std::max(T(0), val);
         }
 
+        template <typename T, T (*F)(T)>
+        static void unaryLoop(T *out, const T *in, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                out[i] = F(in[i]);
+        }
+
         template <typename T>
-        void doCompute(const Operator &_op, const RuntimeObj *context) const
+        KernelRoutine doCompile(const Operator &_op,
+                                const RuntimeObj *context) const
         {
             auto op = as<UnaryObj>(_op);
             T *inptr = op->getInputs(0)->getRawDataPtr<T *>();
             T *outptr = op->getOutput()->getRawDataPtr<T *>();
 
-            auto outDim = op->getOutput()->getDims();
             auto n = op->getOutput()->size();
 
-            T (*_doCompute)
-            (T val);
+            void (*_doCompute)(T *out, const T *in, size_t n) = nullptr;
             switch (op->getOpType().underlying())
             {
             case OpType::Relu:
-                _doCompute = reluCompute<T>;
+                if constexpr (std::is_same_v<T, float>)
+                    _doCompute = getFloatReluLoop();
+                else
+                    _doCompute = unaryLoop<T, reluCompute<T>>;
                 break;
             default:
                 IT_TODO_HALT();
             }
 
-            for (size_t offset = 0; offset < n; offset++)
+            return [=]
+            {
+                forEachChunk(getThreadPool(context), n, [&](size_t offset, size_t len)
+                             { _doCompute(outptr + offset, inptr + offset, len); });
+            };
+        }
+
+        KernelRoutine doCompileHalf(const Operator &_op,
+                                    const RuntimeObj *context) const
+        {
+            auto op = as<UnaryObj>(_op);
+            auto inptr = op->getInputs(0)->getRawDataPtr<uint16_t *>();
+            auto outptr = op->getOutput()->getRawDataPtr<uint16_t *>();
+            auto format = getHalfFormat(op->getDType());
+            auto n = op->getOutput()->size();
+
+            UnaryFloatLoop loop = nullptr;
+            switch (op->getOpType().underlying())
             {
-                outptr[offset] = _doCompute(inptr[offset]);
+            case OpType::Relu:
+                loop = getFloatReluLoop();
+                break;
+            default:
+                IT_TODO_HALT();
             }
+
+            return [=]
+            {
+                forEachChunk(getThreadPool(context), n, [&](size_t offset, size_t len)
+                             { halfLoop(format, outptr + offset,
+                                        inptr + offset, len, loop); });
+            };
         }
 
-        void compute(const Operator &_op,
-                     const RuntimeObj *context) const override
+        KernelRoutine compile(const Operator &_op,
+                              const RuntimeObj *context) const override
         {
 #define CASE(N) \
     case N:     \
-        doCompute<DT<N>::t>(_op, context)
+        return doCompile<DT<N>::t>(_op, context)
 
             int dataTypeIdx = _op->getDType().getIndex();
             switch (dataTypeIdx)
             {
-                CASE(1); // DataType::Float32
-                break;
+                CASE(1);  // DataType::Float32
                 CASE(12); // DataType::UInt32
-                break;
+            case 10:      // DataType::Float16
+            case 16:      // DataType::BFloat16
+                return doCompileHalf(_op, context);
             default:
                 IT_TODO_HALT();
             }
         }
+
+        void compute(const Operator &_op,
+                     const RuntimeObj *context) const override
+        {
+            compile(_op, context)();
+        }
     };
 
     class Clip : public CpuKernelWithoutConfig
     {
         template <typename T>
-        void doCompute(const Operator &_op, const RuntimeObj *context) const
+        KernelRoutine doCompile(const Operator &_op,
+                                const RuntimeObj *context) const
         {
             auto op = as<ClipObj>(_op);
             T *inptr = op->getInputs(0)->getRawDataPtr<T *>();
@@ -70,33 +143,73 @@ namespace infini
             auto maxValue = op->getMax();
 
             auto n = op->getOutput()->size();
-            for (size_t offset = 0; offset < n; offset++)
+            if constexpr (std::is_same_v<T, float>)
             {
-                auto val = *inptr++;
-                *outptr++ = (minValue && val < *minValue)   ? *minValue
-                            : (maxValue && val > *maxValue) ? *maxValue
-                                                            : val;
+                ClipFloatLoop loop = getFloatClipLoop();
+                float lo = minValue.value_or(-INFINITY);
+                float hi = maxValue.value_or(INFINITY);
+                return [=]
+                {
+                    forEachChunk(getThreadPool(context), n, [&](size_t offset, size_t len)
+                                 { loop(outptr + offset, inptr + offset, len, lo, hi); });
+                };
             }
+            return [=]
+            {
+                forEachChunk(getThreadPool(context), n, [&](size_t offset, size_t len)
+                             {
+                    for (size_t i = offset; i < offset + len; i++)
+                    {
+                        auto val = inptr[i];
+                        outptr[i] = (minValue && val < *minValue)   ? *minValue
+                                    : (maxValue && val > *maxValue) ? *maxValue
+                                                                    : val;
+                    } });
+            };
         }
 
-        void compute(const Operator &_op,
-                     const RuntimeObj *context) const override
+        KernelRoutine doCompileHalf(const Operator &_op,
+                                    const RuntimeObj *context) const
         {
-#define CASE(N) \
-    case N:     \
-        doCompute<DT<N>::t>(_op, context)
+            auto op = as<ClipObj>(_op);
+            auto inptr = op->getInputs(0)->getRawDataPtr<uint16_t *>();
+            auto outptr = op->getOutput()->getRawDataPtr<uint16_t *>();
+            auto format = getHalfFormat(op->getDType());
+            auto n = op->getOutput()->size();
+            float lo = op->getMin().value_or(-INFINITY);
+            float hi = op->getMax().value_or(INFINITY);
+            ClipFloatLoop loop = getFloatClipLoop();
+
+            return [=]
+            {
+                forEachChunk(getThreadPool(context), n, [&](size_t offset, size_t len)
+                             { halfLoop(format, outptr + offset, inptr + offset, len,
+                                        [&](float *out, const float *in, size_t m)
+                                        { loop(out, in, m, lo, hi); }); });
+            };
+        }
 
+        KernelRoutine compile(const Operator &_op,
+                              const RuntimeObj *context) const override
+        {
             int dataTypeIdx = _op->getDType().getIndex();
             switch (dataTypeIdx)
             {
-                CASE(1); // DataType::Float32
-                break;
+                CASE(1);  // DataType::Float32
                 CASE(12); // DataType::UInt32
-                break;
+            case 10:      // DataType::Float16
+            case 16:      // DataType::BFloat16
+                return doCompileHalf(_op, context);
             default:
                 IT_TODO_HALT();
             }
         }
+
+        void compute(const Operator &_op,
+                     const RuntimeObj *context) const override
+        {
+            compile(_op, context)();
+        }
     };
 
     REGISTER_KERNEL(Device::CPU, OpType::Relu, NativeUnary, "reluNaive_CPU");
@@ -0,0 +1,59 @@
+#include "operators/fused_element_wise.h"
+#include "utils/operator_utils.h"
+
+namespace infini
+{
+    FusedElementwiseObj::FusedElementwiseObj(GraphObj *graph, TensorVec inputs,
+                                             Tensor output,
+                                             vector<ElementwiseInstr> program)
+        : OperatorObj(OpType::FusedElementwise, inputs, {output}),
+          program(std::move(program))
+    {
+        IT_ASSERT(!this->program.empty());
+        int registers = this->inputs.size();
+        for (auto &instr : this->program)
+        {
+            bool binary = instr.type == OpType::Add ||
+                          instr.type == OpType::Sub ||
+                          instr.type == OpType::Mul ||
+                          instr.type == OpType::Div;
+            IT_ASSERT(binary || instr.type == OpType::Relu ||
+                      instr.type == OpType::Clip);
+            IT_ASSERT(instr.lhs >= 0 && instr.lhs < registers);
+            IT_ASSERT(binary ? instr.rhs >= 0 && instr.rhs < registers
+                             : instr.rhs == -1);
+            ++registers;
+        }
+        IT_ASSERT(checkValid(graph));
+    }
+
+    optional<vector<Shape>> FusedElementwiseObj::inferShape(const TensorVec &inputs)
+    {
+        Shape res = inputs[0]->getDims();
+        for (size_t i = 1; i < inputs.size(); ++i)
+            res = infer_broadcast(res, inputs[i]->getDims());
+        return {{res}};
+    }
+
+    std::string FusedElementwiseObj::toString() const
+    {
+        std::ostringstream os;
+        os << type.toString() << "[" << getGuid() << "](";
+        for (size_t i = 0; i < inputs.size(); ++i)
+            os << "r" << i << "=" << inputs[i]->getGuid() << ",";
+        int reg = inputs.size();
+        for (auto &instr : program)
+        {
+            os << "r" << reg++ << "=" << instr.type.toString() << "(r"
+               << instr.lhs;
+            if (instr.rhs >= 0)
+                os << ",r" << instr.rhs;
+            if (instr.type == OpType::Clip)
+                os << "," << instr.min << "," << instr.max;
+            os << "),";
+        }
+        os << "output=" << outputs[0]->getGuid() << ")";
+        return os.str();
+    }
+
+}; // namespace infini
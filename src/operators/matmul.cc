@@ -1,4 +1,5 @@
 #include "operators/matmul.h"
+#include "utils/operator_utils.h"
 
 namespace infini
 {
@@ -11,13 +12,37 @@ namespace infini
         IT_ASSERT(checkValid(graph));
     }
 
+    MatmulObj::MatmulObj(GraphObj *graph, Tensor A, Tensor B, Tensor C,
+                         bool transA, bool transB, Tensor bias,
+                         Tensor residual, std::optional<float> min,
+                         std::optional<float> max)
+        : OperatorObj(OpType::MatMul, TensorVec{A, B}, {C}), transA(transA),
+          transB(transB), hasBias(bias != nullptr),
+          hasResidual(residual != nullptr), minValue(min), maxValue(max)
+    {
+        if (bias)
+            inputs.push_back(bias);
+        if (residual)
+            inputs.push_back(residual);
+        IT_ASSERT(checkValid(graph));
+    }
+
     string MatmulObj::toString() const
     {
         std::ostringstream os;
         os << "Matmul([" << (transA ? "A^T" : "A") << "," << (transB ? "B^T" : "B]")
            << ",A=" << inputs[0]->getGuid()
            << ",B=" << inputs[1]->getGuid() << ",C=" << outputs[0]->getGuid()
-           << ",mnk=[" << m << "," << n << "," << k << "])";
+           << ",mnk=[" << m << "," << n << "," << k << "]";
+        if (hasBias)
+            os << ",bias=" << getBias()->getGuid();
+        if (hasResidual)
+            os << ",residual=" << getResidual()->getGuid();
+        if (minValue)
+            os << ",min=" << *minValue;
+        if (maxValue)
+            os << ",max=" << *maxValue;
+        os << ")";
         return os.str();
     }
 
@@ -30,31 +55,39 @@ namespace infini
         auto shapeA = inputs[0]->getDims();
         auto shapeB = inputs[1]->getDims();
         IT_ASSERT(shapeA.size() == shapeB.size());
+        auto rank = shapeA.size();
+        IT_ASSERT(rank >= 2);
 
         if (this->getTransA())
         {
-            std::swap(shapeA[shapeA.size() - 1], shapeA[shapeA.size() - 2]);
+            std::swap(shapeA[rank - 1], shapeA[rank - 2]);
         }
 
         if (this->getTransB())
         {
-            std::swap(shapeB[shapeB.size() - 1], shapeB[shapeB.size() - 2]);
+            std::swap(shapeB[rank - 1], shapeB[rank - 2]);
         }
 
-        IT_ASSERT(shapeA[shapeA.size() - 1] == shapeB[shapeB.size() - 2]);
+        IT_ASSERT(shapeA[rank - 1] == shapeB[rank - 2]);
+        m = shapeA[rank - 2];
+        n = shapeB[rank - 1];
+        k = shapeA[rank - 1];
+
+        // leading batch dimensions follow the broadcast rule
+        Shape result = infer_broadcast(Shape(shapeA.begin(), shapeA.end() - 2),
+                                       Shape(shapeB.begin(), shapeB.end() - 2));
+        result.emplace_back(m);
+        result.emplace_back(n);
 
-        Shape result(shapeA.size());
-        for (size_t i = 0; i < result.size(); ++i)
+        if (hasBias)
         {
-            if (i == result.size() - 1)
-            {
-                result[i] = shapeB[i];
-            }
-            else
-            {
-                result[i] = shapeA[i];
-            }
+            auto bias = inputs[2]->getDims();
+            if (bias.size() > result.size() || bias.back() != n ||
+                inputs[2]->size() != size_t(n))
+                return std::nullopt;
         }
+        if (hasResidual && inputs[2 + hasBias]->getDims() != result)
+            return std::nullopt;
 
         // return std::nullopt;
         return vector<Shape>{result};
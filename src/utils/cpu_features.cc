@@ -0,0 +1,60 @@
+#include "utils/cpu_features.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace infini {
+
+static SimdLevel detectSimdLevel() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("fma"))
+        return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+        __builtin_cpu_supports("f16c"))
+        return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.2"))
+        return SimdLevel::SSE42;
+#endif
+    return SimdLevel::Scalar;
+}
+
+static SimdLevel parseSimdLevel(const char *str, SimdLevel fallback) {
+    if (!strcmp(str, "scalar"))
+        return SimdLevel::Scalar;
+    if (!strcmp(str, "sse4.2"))
+        return SimdLevel::SSE42;
+    if (!strcmp(str, "avx2"))
+        return SimdLevel::AVX2;
+    if (!strcmp(str, "avx512"))
+        return SimdLevel::AVX512;
+    return fallback;
+}
+
+SimdLevel getSimdLevel() {
+    static const SimdLevel level = [] {
+        auto detected = detectSimdLevel();
+        if (auto env = std::getenv("INFINI_SIMD"))
+            return std::min(detected, parseSimdLevel(env, detected));
+        return detected;
+    }();
+    return level;
+}
+
+const char *simdLevelToString(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Scalar:
+        return "scalar";
+    case SimdLevel::SSE42:
+        return "sse4.2";
+    case SimdLevel::AVX2:
+        return "avx2";
+    case SimdLevel::AVX512:
+        return "avx512";
+    default:
+        return "unknown";
+    }
+}
+
+} // namespace infini
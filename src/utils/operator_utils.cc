@@ -65,6 +65,114 @@ size_t delocate_index(const Shape &shapeIndex, const Shape &shape,
     return ans;
 }
 
+void collapse_broadcast(Shape &shape, vector<Shape> &inputs) {
+    size_t rank = shape.size();
+    for (auto &input : inputs) {
+        IT_ASSERT(input.size() <= rank);
+        input.insert(input.begin(), rank - input.size(), 1);
+    }
+    Shape newShape;
+    vector<Shape> newInputs(inputs.size());
+    for (size_t d = 0; d < rank; ++d) {
+        if (shape[d] == 1)
+            continue;
+        bool merge = !newShape.empty();
+        for (size_t i = 0; merge && i < inputs.size(); ++i)
+            merge = (newInputs[i].back() == 1) == (inputs[i][d] == 1);
+        if (merge) {
+            newShape.back() *= shape[d];
+            for (size_t i = 0; i < inputs.size(); ++i)
+                newInputs[i].back() *= inputs[i][d];
+        } else {
+            newShape.emplace_back(shape[d]);
+            for (size_t i = 0; i < inputs.size(); ++i)
+                newInputs[i].emplace_back(inputs[i][d]);
+        }
+    }
+    if (newShape.empty()) {
+        newShape.emplace_back(1);
+        for (auto &input : newInputs)
+            input.emplace_back(1);
+    }
+    shape = std::move(newShape);
+    inputs = std::move(newInputs);
+}
+
+Shape broadcast_strides(const Shape &input, const Shape &shape) {
+    IT_ASSERT(input.size() == shape.size());
+    Shape stride(input.size());
+    int p = 1;
+    for (size_t i = input.size(); i > 0; --i) {
+        stride[i - 1] = (input[i - 1] == 1 && shape[i - 1] != 1) ? 0 : p;
+        p *= input[i - 1];
+    }
+    return stride;
+}
+
+Shape broadcast_strides(const Tensor &input, const Shape &shape) {
+    auto dims = input->getDims(), strides = input->getStrides();
+    IT_ASSERT(dims.size() <= shape.size());
+    size_t pad = shape.size() - dims.size();
+    Shape stride(shape.size(), 0);
+    for (size_t d = 0; d < dims.size(); ++d)
+        if (dims[d] != 1)
+            stride[pad + d] = strides[d];
+    return stride;
+}
+
+void collapse_strides(Shape &shape, vector<Shape> &strides) {
+    Shape newShape;
+    vector<Shape> newStrides(strides.size());
+    for (size_t d = 0; d < shape.size(); ++d) {
+        if (shape[d] == 1)
+            continue;
+        bool merge = !newShape.empty();
+        for (size_t i = 0; merge && i < strides.size(); ++i)
+            merge = newStrides[i].back() == strides[i][d] * shape[d];
+        if (merge) {
+            newShape.back() *= shape[d];
+            for (size_t i = 0; i < strides.size(); ++i)
+                newStrides[i].back() = strides[i][d];
+        } else {
+            newShape.emplace_back(shape[d]);
+            for (size_t i = 0; i < strides.size(); ++i)
+                newStrides[i].emplace_back(strides[i][d]);
+        }
+    }
+    if (newShape.empty()) {
+        newShape.emplace_back(1);
+        for (auto &stride : newStrides)
+            stride.emplace_back(0);
+    }
+    shape = std::move(newShape);
+    strides = std::move(newStrides);
+}
+
+BroadcastRowIterator::BroadcastRowIterator(const Shape &shape,
+                                           const vector<Shape> &strides,
+                                           size_t row)
+    : shape(shape), strides(strides), index(shape.size(), 0),
+      offsets(strides.size(), 0) {
+    for (size_t d = shape.size() - 1; d-- > 0;) {
+        index[d] = row % shape[d];
+        row /= shape[d];
+        for (size_t i = 0; i < strides.size(); ++i)
+            offsets[i] += (size_t)index[d] * strides[i][d];
+    }
+}
+
+void BroadcastRowIterator::next() {
+    for (size_t d = shape.size() - 1; d-- > 0;) {
+        for (size_t i = 0; i < strides.size(); ++i)
+            offsets[i] += strides[i][d];
+        if (++index[d] < shape[d])
+            return;
+        for (size_t i = 0; i < strides.size(); ++i)
+            offsets[i] -= (size_t)shape[d] * strides[i][d];
+        index[d] = 0;
+    }
+}
+
 std::string device_to_str(Device device) {
     std::string deviceStr;
     switch (device) {
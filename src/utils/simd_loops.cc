@@ -0,0 +1,426 @@
+#include "utils/simd_loops.h"
+#include "utils/cpu_features.h"
+#include "utils/half.h"
+#include <algorithm>
+#include <functional>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace infini {
+
+static void halfToFloatRef(float *out, const uint16_t *in, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = half_to_float(in[i]);
+}
+
+static void floatToHalfRef(uint16_t *out, const float *in, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = float_to_half(in[i]);
+}
+
+static void bfloat16ToFloatRef(float *out, const uint16_t *in, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = bfloat16_to_float(in[i]);
+}
+
+static void floatToBfloat16Ref(uint16_t *out, const float *in, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = float_to_bfloat16(in[i]);
+}
+
+template <typename F>
+static void vvRef(float *out, const float *a, const float *b, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = F()(a[i], b[i]);
+}
+
+template <typename F>
+static void vsRef(float *out, const float *a, float b, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = F()(a[i], b);
+}
+
+template <typename F>
+static void svRef(float *out, float a, const float *b, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = F()(a, b[i]);
+}
+
+template <typename F>
+static const BinaryLoops<float> binaryRef{vvRef<F>, vsRef<F>, svRef<F>};
+
+static void reluRef(float *out, const float *in, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = std::max(0.f, in[i]);
+}
+
+static void clipRef(float *out, const float *in, size_t n, float minValue,
+                    float maxValue) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = in[i] < minValue   ? minValue
+                 : in[i] > maxValue ? maxValue
+                                    : in[i];
+}
+
+#if defined(__x86_64__)
+
+// Defines the float loops for one instruction set. Expects `vfloat`,
+// `WIDTH` and the v* helpers in the enclosing namespace, each compiled for
+// that instruction set.
+#define DEFINE_BINARY_LOOPS(NAME, VOP, SOP)                                    \
+    static void NAME##VV(float *out, const float *a, const float *b,           \
+                         size_t n) {                                           \
+        size_t i = 0;                                                          \
+        for (; i + WIDTH <= n; i += WIDTH)                                     \
+            vstore(out + i, VOP(vload(a + i), vload(b + i)));                  \
+        for (; i < n; ++i)                                                     \
+            out[i] = a[i] SOP b[i];                                            \
+    }                                                                          \
+    static void NAME##VS(float *out, const float *a, float b, size_t n) {      \
+        size_t i = 0;                                                          \
+        vfloat vb = vset1(b);                                                  \
+        for (; i + WIDTH <= n; i += WIDTH)                                     \
+            vstore(out + i, VOP(vload(a + i), vb));                            \
+        for (; i < n; ++i)                                                     \
+            out[i] = a[i] SOP b;                                               \
+    }                                                                          \
+    static void NAME##SV(float *out, float a, const float *b, size_t n) {      \
+        size_t i = 0;                                                          \
+        vfloat va = vset1(a);                                                  \
+        for (; i + WIDTH <= n; i += WIDTH)                                     \
+            vstore(out + i, VOP(va, vload(b + i)));                            \
+        for (; i < n; ++i)                                                     \
+            out[i] = a SOP b[i];                                               \
+    }
+
+// vmax(lo, x) and vmin(hi, x) return x when it is NaN, as the scalar Clip
+// does; Relu follows std::max(0, x) and maps NaN to 0.
+#define DEFINE_FLOAT_LOOPS()                                                   \
+    DEFINE_BINARY_LOOPS(add, vadd, +)                                          \
+    DEFINE_BINARY_LOOPS(sub, vsub, -)                                          \
+    DEFINE_BINARY_LOOPS(mul, vmul, *)                                          \
+    DEFINE_BINARY_LOOPS(div, vdiv, /)                                          \
+    static void relu(float *out, const float *in, size_t n) {                  \
+        size_t i = 0;                                                          \
+        vfloat zero = vset1(0.f);                                              \
+        for (; i + WIDTH <= n; i += WIDTH)                                     \
+            vstore(out + i, vmax(vload(in + i), zero));                        \
+        for (; i < n; ++i)                                                     \
+            out[i] = std::max(0.f, in[i]);                                     \
+    }                                                                          \
+    static void clip(float *out, const float *in, size_t n, float minValue,    \
+                     float maxValue) {                                         \
+        size_t i = 0;                                                          \
+        vfloat lo = vset1(minValue), hi = vset1(maxValue);                     \
+        for (; i + WIDTH <= n; i += WIDTH)                                     \
+            vstore(out + i, vmin(hi, vmax(lo, vload(in + i))));                \
+        for (; i < n; ++i) {                                                   \
+            float val = in[i];                                                 \
+            out[i] = val < minValue ? minValue : val > maxValue ? maxValue : val; \
+        }                                                                      \
+    }                                                                          \
+    static const BinaryLoops<float> addLoops{addVV, addVS, addSV};             \
+    static const BinaryLoops<float> subLoops{subVV, subVS, subSV};             \
+    static const BinaryLoops<float> mulLoops{mulVV, mulVS, mulSV};             \
+    static const BinaryLoops<float> divLoops{divVV, divVS, divSV};
+
+// Defines FROM##ToFloat and floatTo##TO for a 16-bit float format, given
+// the vload##SUFFIX / vstore##SUFFIX helpers that widen and narrow WIDTH
+// elements.
+#define DEFINE_CONVERT_LOOPS(FROM, TO, SUFFIX, SCALAR_FROM, SCALAR_TO)         \
+    static void FROM##ToFloat(float *out, const uint16_t *in, size_t n) {      \
+        size_t i = 0;                                                          \
+        for (; i + WIDTH <= n; i += WIDTH)                                     \
+            vstore(out + i, vload##SUFFIX(in + i));                            \
+        for (; i < n; ++i)                                                     \
+            out[i] = SCALAR_FROM(in[i]);                                       \
+    }                                                                          \
+    static void floatTo##TO(uint16_t *out, const float *in, size_t n) {        \
+        size_t i = 0;                                                          \
+        for (; i + WIDTH <= n; i += WIDTH)                                     \
+            vstore##SUFFIX(out + i, vload(in + i));                            \
+        for (; i < n; ++i)                                                     \
+            out[i] = SCALAR_TO(in[i]);                                         \
+    }
+
+// BFloat16 is the upper half of a float: widening is a shift, narrowing
+// adds the round-to-nearest-even bias and keeps NaN quiet, as
+// float_to_bfloat16 does.
+#define DEFINE_BFLOAT16_LOOPS()                                                \
+    DEFINE_CONVERT_LOOPS(bfloat16, Bfloat16, Bfloat16, bfloat16_to_float,      \
+                         float_to_bfloat16)
+
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+namespace sse42 {
+using vfloat = __m128;
+constexpr size_t WIDTH = 4;
+static inline vfloat vload(const float *p) { return _mm_loadu_ps(p); }
+static inline void vstore(float *p, vfloat v) { _mm_storeu_ps(p, v); }
+static inline vfloat vset1(float x) { return _mm_set1_ps(x); }
+static inline vfloat vadd(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+static inline vfloat vsub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+static inline vfloat vmul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+static inline vfloat vdiv(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+static inline vfloat vmax(vfloat a, vfloat b) { return _mm_max_ps(a, b); }
+static inline vfloat vmin(vfloat a, vfloat b) { return _mm_min_ps(a, b); }
+static inline vfloat vloadBfloat16(const uint16_t *p) {
+    __m128i h = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p));
+    return _mm_castsi128_ps(_mm_slli_epi32(_mm_cvtepu16_epi32(h), 16));
+}
+static inline __m128i roundBfloat16(__m128 v) {
+    __m128i x = _mm_castps_si128(v);
+    __m128i lsb = _mm_and_si128(_mm_srli_epi32(x, 16), _mm_set1_epi32(1));
+    __m128i r = _mm_add_epi32(x, _mm_add_epi32(lsb, _mm_set1_epi32(0x7FFF)));
+    __m128i nan = _mm_cmpgt_epi32(_mm_and_si128(x, _mm_set1_epi32(0x7FFFFFFF)),
+                                  _mm_set1_epi32(0x7F800000));
+    r = _mm_blendv_epi8(r, _mm_or_si128(x, _mm_set1_epi32(0x400000)), nan);
+    return _mm_srli_epi32(r, 16);
+}
+static inline void vstoreBfloat16(uint16_t *p, vfloat v) {
+    __m128i r = roundBfloat16(v);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_packus_epi32(r, r));
+}
+DEFINE_FLOAT_LOOPS()
+DEFINE_BFLOAT16_LOOPS()
+static const HalfConvertLoops convertLoops{halfToFloatRef, floatToHalfRef,
+                                           bfloat16ToFloat, floatToBfloat16};
+} // namespace sse42
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,f16c")
+namespace avx2 {
+using vfloat = __m256;
+constexpr size_t WIDTH = 8;
+static inline vfloat vload(const float *p) { return _mm256_loadu_ps(p); }
+static inline void vstore(float *p, vfloat v) { _mm256_storeu_ps(p, v); }
+static inline vfloat vset1(float x) { return _mm256_set1_ps(x); }
+static inline vfloat vadd(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+static inline vfloat vsub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+static inline vfloat vmul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+static inline vfloat vdiv(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+static inline vfloat vmax(vfloat a, vfloat b) { return _mm256_max_ps(a, b); }
+static inline vfloat vmin(vfloat a, vfloat b) { return _mm256_min_ps(a, b); }
+static inline vfloat vloadHalf(const uint16_t *p) {
+    return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+static inline void vstoreHalf(uint16_t *p, vfloat v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p),
+                     _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+}
+static inline vfloat vloadBfloat16(const uint16_t *p) {
+    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+}
+static inline void vstoreBfloat16(uint16_t *p, vfloat v) {
+    __m256i x = _mm256_castps_si256(v);
+    __m256i lsb =
+        _mm256_and_si256(_mm256_srli_epi32(x, 16), _mm256_set1_epi32(1));
+    __m256i r =
+        _mm256_add_epi32(x, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7FFF)));
+    __m256i nan = _mm256_cmpgt_epi32(
+        _mm256_and_si256(x, _mm256_set1_epi32(0x7FFFFFFF)),
+        _mm256_set1_epi32(0x7F800000));
+    r = _mm256_blendv_epi8(r, _mm256_or_si256(x, _mm256_set1_epi32(0x400000)),
+                           nan);
+    r = _mm256_srli_epi32(r, 16);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p),
+                     _mm_packus_epi32(_mm256_castsi256_si128(r),
+                                      _mm256_extracti128_si256(r, 1)));
+}
+DEFINE_FLOAT_LOOPS()
+DEFINE_CONVERT_LOOPS(half, Half, Half, half_to_float, float_to_half)
+DEFINE_BFLOAT16_LOOPS()
+static const HalfConvertLoops convertLoops{halfToFloat, floatToHalf,
+                                           bfloat16ToFloat, floatToBfloat16};
+} // namespace avx2
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+// _mm512_max_ps/_mm512_min_ps start from _mm512_undefined_ps(), which GCC 12
+// reports as maybe-uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+namespace avx512 {
+using vfloat = __m512;
+constexpr size_t WIDTH = 16;
+static inline vfloat vload(const float *p) { return _mm512_loadu_ps(p); }
+static inline void vstore(float *p, vfloat v) { _mm512_storeu_ps(p, v); }
+static inline vfloat vset1(float x) { return _mm512_set1_ps(x); }
+static inline vfloat vadd(vfloat a, vfloat b) { return _mm512_add_ps(a, b); }
+static inline vfloat vsub(vfloat a, vfloat b) { return _mm512_sub_ps(a, b); }
+static inline vfloat vmul(vfloat a, vfloat b) { return _mm512_mul_ps(a, b); }
+static inline vfloat vdiv(vfloat a, vfloat b) { return _mm512_div_ps(a, b); }
+static inline vfloat vmax(vfloat a, vfloat b) { return _mm512_max_ps(a, b); }
+static inline vfloat vmin(vfloat a, vfloat b) { return _mm512_min_ps(a, b); }
+static inline vfloat vloadHalf(const uint16_t *p) {
+    return _mm512_cvtph_ps(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+}
+static inline void vstoreHalf(uint16_t *p, vfloat v) {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(p),
+        _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+static inline vfloat vloadBfloat16(const uint16_t *p) {
+    __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(h), 16));
+}
+static inline void vstoreBfloat16(uint16_t *p, vfloat v) {
+    __m512i x = _mm512_castps_si512(v);
+    __m512i lsb =
+        _mm512_and_si512(_mm512_srli_epi32(x, 16), _mm512_set1_epi32(1));
+    __m512i r =
+        _mm512_add_epi32(x, _mm512_add_epi32(lsb, _mm512_set1_epi32(0x7FFF)));
+    __mmask16 nan = _mm512_cmpgt_epi32_mask(
+        _mm512_and_si512(x, _mm512_set1_epi32(0x7FFFFFFF)),
+        _mm512_set1_epi32(0x7F800000));
+    r = _mm512_mask_blend_epi32(
+        nan, r, _mm512_or_si512(x, _mm512_set1_epi32(0x400000)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p),
+                        _mm512_cvtepi32_epi16(_mm512_srli_epi32(r, 16)));
+}
+DEFINE_FLOAT_LOOPS()
+DEFINE_CONVERT_LOOPS(half, Half, Half, half_to_float, float_to_half)
+DEFINE_BFLOAT16_LOOPS()
+static const HalfConvertLoops convertLoops{halfToFloat, floatToHalf,
+                                           bfloat16ToFloat, floatToBfloat16};
+} // namespace avx512
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+
+#undef DEFINE_BFLOAT16_LOOPS
+#undef DEFINE_CONVERT_LOOPS
+#undef DEFINE_FLOAT_LOOPS
+#undef DEFINE_BINARY_LOOPS
+
+#define SELECT_BY_SIMD_LEVEL(NAME)                                             \
+    switch (getSimdLevel()) {                                                  \
+    case SimdLevel::AVX512:                                                    \
+        return &avx512::NAME;                                                  \
+    case SimdLevel::AVX2:                                                      \
+        return &avx2::NAME;                                                    \
+    case SimdLevel::SSE42:                                                     \
+        return &sse42::NAME;                                                   \
+    default:                                                                   \
+        return nullptr;                                                        \
+    }
+
+static const BinaryLoops<float> *selectBinaryLoops(OpType type) {
+    switch (type.underlying()) {
+    case OpType::Add: {
+        SELECT_BY_SIMD_LEVEL(addLoops)
+    }
+    case OpType::Sub: {
+        SELECT_BY_SIMD_LEVEL(subLoops)
+    }
+    case OpType::Mul: {
+        SELECT_BY_SIMD_LEVEL(mulLoops)
+    }
+    case OpType::Div: {
+        SELECT_BY_SIMD_LEVEL(divLoops)
+    }
+    default:
+        return nullptr;
+    }
+}
+
+const BinaryLoops<float> *getSimdBinaryLoops(OpType type) {
+    static const BinaryLoops<float> *add = selectBinaryLoops(OpType::Add),
+                                    *sub = selectBinaryLoops(OpType::Sub),
+                                    *mul = selectBinaryLoops(OpType::Mul),
+                                    *div = selectBinaryLoops(OpType::Div);
+    switch (type.underlying()) {
+    case OpType::Add:
+        return add;
+    case OpType::Sub:
+        return sub;
+    case OpType::Mul:
+        return mul;
+    case OpType::Div:
+        return div;
+    default:
+        return nullptr;
+    }
+}
+
+UnaryFloatLoop getSimdReluLoop() {
+    static const UnaryFloatLoop loop = []() -> UnaryFloatLoop {
+        SELECT_BY_SIMD_LEVEL(relu)
+    }();
+    return loop;
+}
+
+ClipFloatLoop getSimdClipLoop() {
+    static const ClipFloatLoop loop = []() -> ClipFloatLoop {
+        SELECT_BY_SIMD_LEVEL(clip)
+    }();
+    return loop;
+}
+
+const HalfConvertLoops &getHalfConvertLoops() {
+    static const HalfConvertLoops refLoops{halfToFloatRef, floatToHalfRef,
+                                           bfloat16ToFloatRef,
+                                           floatToBfloat16Ref};
+    static const HalfConvertLoops *loops = []() -> const HalfConvertLoops * {
+        SELECT_BY_SIMD_LEVEL(convertLoops)
+    }();
+    return loops ? *loops : refLoops;
+}
+
+#undef SELECT_BY_SIMD_LEVEL
+
+#else
+
+const BinaryLoops<float> *getSimdBinaryLoops(OpType type) { return nullptr; }
+UnaryFloatLoop getSimdReluLoop() { return nullptr; }
+ClipFloatLoop getSimdClipLoop() { return nullptr; }
+
+const HalfConvertLoops &getHalfConvertLoops() {
+    static const HalfConvertLoops refLoops{halfToFloatRef, floatToHalfRef,
+                                           bfloat16ToFloatRef,
+                                           floatToBfloat16Ref};
+    return refLoops;
+}
+
+#endif
+
+const BinaryLoops<float> &getFloatBinaryLoops(OpType type) {
+    if (auto loops = getSimdBinaryLoops(type))
+        return *loops;
+    switch (type.underlying()) {
+    case OpType::Add:
+        return binaryRef<std::plus<float>>;
+    case OpType::Sub:
+        return binaryRef<std::minus<float>>;
+    case OpType::Mul:
+        return binaryRef<std::multiplies<float>>;
+    case OpType::Div:
+        return binaryRef<std::divides<float>>;
+    default:
+        IT_TODO_HALT();
+    }
+}
+
+UnaryFloatLoop getFloatReluLoop() {
+    auto loop = getSimdReluLoop();
+    return loop ? loop : reluRef;
+}
+
+ClipFloatLoop getFloatClipLoop() {
+    auto loop = getSimdClipLoop();
+    return loop ? loop : clipRef;
+}
+
+HalfFormat getHalfFormat(DataType dtype) {
+    const auto &loops = getHalfConvertLoops();
+    if (dtype == DataType::Float16)
+        return {loops.halfToFloat, loops.floatToHalf};
+    IT_ASSERT(dtype == DataType::BFloat16);
+    return {loops.bfloat16ToFloat, loops.floatToBfloat16};
+}
+
+} // namespace infini
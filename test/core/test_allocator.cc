@@ -1,9 +1,11 @@
 #include "core/graph.h"
 #include "core/kernel.h"
 #include "core/runtime.h"
+#include "operators/transpose.h"
 #include "operators/unary.h"
 
 #include "test.h"
+#include <cstring>
 
 namespace infini
 {
@@ -71,4 +73,93 @@ namespace infini
         EXPECT_EQ(ptr1, ptr2);
     }
 
+    TEST(Allocator, testCoalesce)
+    {
+        Shape shape = Shape{1, 2, 2, 3};
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Tensor a = make_ref<TensorObj>(shape, DataType::Float32, runtime);
+        Tensor big =
+            make_ref<TensorObj>(Shape{3, 2, 2, 3}, DataType::Float32, runtime);
+        Allocator allocator = Allocator(runtime);
+        // allocate a->b->c->d
+        size_t offsetA = allocator.alloc(a->getBytes());
+        size_t offsetB = allocator.alloc(a->getBytes());
+        size_t offsetC = allocator.alloc(a->getBytes());
+        allocator.alloc(a->getBytes());
+        // free a and c, leaving two holes that are too small for big
+        allocator.free(offsetA, a->getBytes());
+        allocator.free(offsetC, a->getBytes());
+        EXPECT_DOUBLE_EQ(allocator.getFragmentation(), 0.5);
+        // freeing b merges a, b and c into one block that fits big
+        allocator.free(offsetB, a->getBytes());
+        EXPECT_DOUBLE_EQ(allocator.getFragmentation(), 0.);
+        EXPECT_EQ(allocator.alloc(big->getBytes()), offsetA);
+    }
+
+    TEST(Allocator, testBestFit)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Allocator allocator = Allocator(runtime);
+        size_t offsetA = allocator.alloc(64);
+        allocator.alloc(8);
+        size_t offsetC = allocator.alloc(16);
+        allocator.alloc(8);
+        allocator.free(offsetA, 64);
+        allocator.free(offsetC, 16);
+        // the 16-byte hole is the tightest fit, the 64-byte one stays whole
+        EXPECT_EQ(allocator.alloc(16), offsetC);
+        EXPECT_EQ(allocator.alloc(64), offsetA);
+    }
+
+    TEST(Allocator, testEmptyBlocks)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Allocator allocator = Allocator(runtime);
+        // an empty block has an address of its own
+        size_t empty = allocator.alloc(0);
+        size_t block = allocator.alloc(64);
+        EXPECT_NE(empty, block);
+        allocator.free(empty, 0);
+        allocator.free(block, 64);
+        EXPECT_DOUBLE_EQ(allocator.getFragmentation(), 0.);
+
+        // empty tensors planned next to others, e.g. an empty K in a matmul
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor e = g->addTensor({0, 4}, DataType::Float32);
+        Tensor x = g->addTensor({2, 4}, DataType::Float32);
+        auto r = g->addOp<ReluObj>(e, nullptr)->getOutput();
+        g->addOp<TransposeObj>(r, nullptr, Shape{1, 0});
+        auto s = g->addOp<ReluObj>(x, nullptr)->getOutput();
+        g->addOp<TransposeObj>(s, nullptr, Shape{1, 0});
+        g->dataMalloc();
+        x->setData(IncrementalGenerator());
+        runtime->run(g);
+    }
+
+    TEST(Allocator, RuntimeAllocAlignsBlocks)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        auto aligned = [](void *ptr, size_t alignment)
+        { return reinterpret_cast<uintptr_t>(ptr) % alignment == 0; };
+        void *small = runtime->alloc(24);
+        void *large = runtime->alloc(1 << 20);
+        EXPECT_TRUE(aligned(small, 64));
+        EXPECT_TRUE(aligned(large, 4096));
+
+        runtime->setAllocPolicy({256, true, true});
+        void *padded = runtime->alloc(24);
+        EXPECT_TRUE(aligned(padded, 256));
+        // huge blocks are aligned to a huge page and prefaulted, which
+        // leaves them readable
+        size_t bytes = 3 * HUGE_PAGE_BYTES + 100;
+        auto huge = static_cast<char *>(runtime->alloc(bytes));
+        EXPECT_TRUE(aligned(huge, HUGE_PAGE_BYTES));
+        std::memset(huge, 1, bytes);
+        EXPECT_EQ(huge[bytes - 1], 1);
+
+        EXPECT_THROW(runtime->setAllocPolicy({48}), Exception);
+        for (void *ptr : {small, large, padded, static_cast<void *>(huge)})
+            runtime->dealloc(ptr);
+    }
+
 } // namespace infini
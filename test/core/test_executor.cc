@@ -0,0 +1,94 @@
+#include "core/executor.h"
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/unary.h"
+
+#include "test.h"
+
+namespace infini
+{
+    TEST(InterOpExecutor, ReusedBlocksAddEdges)
+    {
+        Runtime runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({8, 8}, DataType::Float32);
+        // matmuls, unlike Relu, never write over their input, and unlike
+        // Transpose never become views
+        auto a = g->addOp<MatmulObj>(i, i, nullptr)->getOutput();
+        auto b = g->addOp<MatmulObj>(i, i, nullptr)->getOutput();
+        auto c = g->addOp<MatmulObj>(a, i, nullptr)->getOutput();
+        auto d = g->addOp<MatmulObj>(b, i, nullptr)->getOutput();
+        g->addOp<AddObj>(c, d, nullptr);
+        g->dataMalloc();
+        // d is written into the block a released, so besides b it waits
+        // for a and its reader c
+        ASSERT_EQ(a->getRawDataPtr<void *>(), d->getRawDataPtr<void *>());
+        const auto &entries = g->getPlan().getEntriesWithDependencies();
+        ASSERT_EQ(entries.size(), 5);
+        EXPECT_EQ(entries[2].op, c->getSource());
+        EXPECT_EQ(entries[2].successors, (vector<size_t>{3, 4}));
+        EXPECT_EQ(entries[3].numPredecessors, 3);
+    }
+
+    TEST(InterOpExecutor, InPlaceChainsGetOneEdgePerOp)
+    {
+        Runtime runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        const size_t n = 20000;
+        Tensor t = g->addTensor({2, 8}, DataType::Float32);
+        for (size_t i = 0; i < n; ++i)
+            t = g->addOp<ReluObj>(t, nullptr)->getOutput();
+        g->dataMalloc();
+        const auto &plan = g->getPlan();
+        // sequential runs never build the edges
+        EXPECT_TRUE(plan.getEntries()[0].successors.empty());
+        // every intermediate shares one block, but only the last writer of
+        // a range is waited on
+        const auto &entries = plan.getEntriesWithDependencies();
+        ASSERT_EQ(entries.size(), n);
+        for (size_t i = 0; i + 1 < n; ++i)
+            ASSERT_EQ(entries[i].successors, vector<size_t>{i + 1});
+        EXPECT_EQ(entries[0].numPredecessors, 0);
+    }
+
+    TEST(InterOpExecutor, MatchesSequentialRun)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        const int branches = 8, rows = 64, cols = 64;
+        Tensor i = g->addTensor({rows, cols}, DataType::Float32);
+        // branch k adds i to itself k + 1 times, leaving (k + 2) * i
+        TensorVec outputs;
+        for (int k = 0; k < branches; ++k)
+        {
+            Tensor t = i;
+            for (int j = 0; j <= k; ++j)
+                t = g->addOp<AddObj>(t, i, nullptr)->getOutput();
+            outputs.push_back(t);
+        }
+        auto o = g->addOp<ConcatObj>(outputs, nullptr, 0)->getOutput();
+        g->dataMalloc();
+        i->setData(IncrementalGenerator());
+
+        vector<float> ans(o->size());
+        for (int k = 0; k < branches; ++k)
+            for (int j = 0; j < rows * cols; ++j)
+                ans[k * rows * cols + j] = float((k + 2) * j);
+
+        runtime->run(g);
+        EXPECT_TRUE(o->equalData(ans));
+        runtime->setInterOpThreads(4);
+        EXPECT_EQ(runtime->getInterOpThreads(), 4);
+        for (int run = 0; run < 20; ++run)
+        {
+            o->setData(ZeroGenerator());
+            runtime->run(g);
+            ASSERT_TRUE(o->equalData(ans));
+        }
+        runtime->setInterOpThreads(1);
+        EXPECT_EQ(runtime->getInterOpThreads(), 1);
+    }
+}
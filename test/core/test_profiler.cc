@@ -0,0 +1,73 @@
+#include "core/graph.h"
+#include "core/profiler.h"
+#include "core/runtime.h"
+#include "operators/matmul.h"
+#include "operators/unary.h"
+
+#include "test.h"
+
+namespace infini
+{
+    static Graph buildMatmulRelu(Runtime runtime)
+    {
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor a = g->addTensor({2, 4, 8}, DataType::Float32);
+        Tensor b = g->addTensor({2, 8, 3}, DataType::Float32);
+        auto c = g->addOp<MatmulObj>(a, b, nullptr)->getOutput();
+        g->addOp<ReluObj>(c, nullptr);
+        g->dataMalloc();
+        a->setData(IncrementalGenerator());
+        b->setData(IncrementalGenerator());
+        return g;
+    }
+
+    TEST(Profiler, RecordsEveryOperator)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = buildMatmulRelu(runtime);
+        runtime->run(g);
+        EXPECT_TRUE(runtime->getProfiler().getRecords().empty());
+
+        runtime->setProfiling(true);
+        runtime->run(g);
+        runtime->run(g);
+        runtime->setProfiling(false);
+        runtime->run(g);
+
+        auto records = runtime->getProfiler().getRecords();
+        ASSERT_EQ(records.size(), 4);
+        const auto &matmul = records[0];
+        EXPECT_EQ(matmul.kernel, "Matmul_CPU");
+        EXPECT_EQ(matmul.opType, OpType::MatMul);
+        EXPECT_EQ(matmul.inputs, (vector<Shape>{{2, 4, 8}, {2, 8, 3}}));
+        EXPECT_EQ(matmul.outputs, (vector<Shape>{{2, 4, 3}}));
+        EXPECT_EQ(matmul.flops, 2.0 * 2 * 4 * 3 * 8);
+        EXPECT_EQ(matmul.bytes, 4.0 * (64 + 48 + 24));
+        EXPECT_GE(matmul.duration, 0);
+        const auto &relu = records[1];
+        EXPECT_EQ(relu.kernel, "reluNaive_CPU");
+        EXPECT_EQ(relu.flops, 24);
+        EXPECT_GE(relu.start, matmul.start + matmul.duration);
+
+        auto summary = runtime->getProfiler().summary();
+        EXPECT_NE(summary.find("Matmul_CPU"), string::npos);
+        EXPECT_NE(summary.find("reluNaive_CPU"), string::npos);
+        runtime->getProfiler().clear();
+        EXPECT_TRUE(runtime->getProfiler().getRecords().empty());
+    }
+
+    TEST(Profiler, ChromeTrace)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        runtime->setInterOpThreads(2);
+        runtime->setProfiling(true);
+        Graph g = buildMatmulRelu(runtime);
+        runtime->run(g);
+        auto trace = runtime->getProfiler().toChromeTrace();
+        EXPECT_EQ(trace.find("{\"traceEvents\":["), 0);
+        EXPECT_NE(trace.find("\"name\":\"MatMul\""), string::npos);
+        EXPECT_NE(trace.find("\"ph\":\"X\""), string::npos);
+        EXPECT_NE(trace.find("\"inputs\":\"[2,4,8],[2,8,3]\""), string::npos);
+        EXPECT_EQ(runtime->getProfiler().getRecords().size(), 2);
+    }
+}
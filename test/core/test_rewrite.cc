@@ -0,0 +1,324 @@
+#include "core/graph.h"
+#include "core/rewrite.h"
+#include "core/runtime.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/fused_element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#include "utils/data_generator.h"
+
+namespace infini
+{
+    TEST(Rewrite, ReplaceAllUsesErasesDeadProducers)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        auto a = g->addOp<ReluObj>(i, nullptr)->getOutput();
+        auto b = g->addOp<ReluObj>(a, nullptr)->getOutput();
+        auto out = g->addOp<ReluObj>(b, nullptr);
+        g->replaceAllUses(b, i);
+        // both producers of b are left without consumers and go with it
+        ASSERT_EQ(g->getOperators().size(), 1);
+        EXPECT_EQ(g->getOperators()[0], out);
+        EXPECT_EQ(g->getTensors().size(), 2);
+        EXPECT_EQ(out->getInputs(0), i);
+        EXPECT_TRUE(out->getPredecessors().empty());
+        EXPECT_EQ(i->getTargets(), OpVec{out});
+        EXPECT_TRUE(g->checkValid());
+    }
+
+    static PassManager::RuleStats statsOf(const PassManager &passes,
+                                          const string &name)
+    {
+        for (size_t i = 0; i < passes.getRules().size(); ++i)
+            if (passes.getRules()[i].name == name)
+                return passes.getStats()[i];
+        return {};
+    }
+
+    TEST(Rewrite, ComposesTransposeChains)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3, 4}, DataType::Float32);
+        auto t = g->addOp<TransposeObj>(i, nullptr, Shape{1, 2, 0})
+                     ->getOutput();
+        auto second = g->addOp<TransposeObj>(t, nullptr, Shape{1, 2, 0});
+        g->addOp<ReluObj>(second->getOutput(), nullptr);
+
+        PassManager passes(defaultRewriteRules());
+        EXPECT_EQ(passes.run(*g), 1);
+        EXPECT_EQ(g->getOperators().size(), 2);
+        EXPECT_EQ(second->getInputs(0), i);
+        EXPECT_EQ(second->getPermute(), (vector<int>{2, 0, 1}));
+        // each transpose is offered once per round to the rule
+        EXPECT_EQ(statsOf(passes, "compose-transposes").attempts, 3);
+        EXPECT_EQ(statsOf(passes, "compose-transposes").applied, 1);
+    }
+
+    TEST(Rewrite, RunsCutOffBeforeAFixedPointAreCounted)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        g->addOp<ReluObj>(i, nullptr);
+
+        // matches forever without changing anything
+        RewriteRule restless{"restless", OpType::Relu,
+                             [](const Operator &) { return true; },
+                             [](GraphObj &, const Operator &) {}};
+        PassManager passes({restless});
+        EXPECT_EQ(passes.run(*g, 3), 3);
+        EXPECT_EQ(passes.getCutOffRuns(), 1);
+
+        PassManager defaults(defaultRewriteRules());
+        defaults.run(*g);
+        EXPECT_EQ(defaults.getCutOffRuns(), 0);
+    }
+
+    TEST(Rewrite, IdentityTransposeOnGraphOutputIsKept)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3, 4}, DataType::Float32);
+        auto t = g->addOp<TransposeObj>(i, nullptr, Shape{1, 2, 0})
+                     ->getOutput();
+        auto o = g->addOp<TransposeObj>(t, nullptr, Shape{2, 0, 1})
+                     ->getOutput();
+        g->optimize();
+        // the inverse pair composes into an identity, which still has to
+        // write the graph output
+        ASSERT_EQ(g->getOperators().size(), 1);
+        EXPECT_EQ(g->getOperators()[0]->getInputs(0), i);
+        EXPECT_EQ(g->getOutputs(), TensorVec{o});
+    }
+
+    // Runs `build` on two graphs, optimizes one and compares the outputs.
+    static void checkOptimizedMatches(std::function<void(const Graph &)> build,
+                                      size_t expectedOps)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph ref = make_ref<GraphObj>(runtime), g = make_ref<GraphObj>(runtime);
+        build(ref);
+        build(g);
+        g->optimize();
+        EXPECT_EQ(g->getOperators().size(), expectedOps);
+        for (auto graph : {ref, g})
+        {
+            graph->dataMalloc();
+            for (auto &input : graph->getInputs())
+                input->setData(IncrementalGenerator());
+            runtime->run(graph);
+        }
+        ASSERT_EQ(g->getOutputs().size(), 1);
+        EXPECT_EQ(g->getOutputs()[0]->getDims(), ref->getOutputs()[0]->getDims());
+        EXPECT_TRUE(g->getOutputs()[0]->equalData(ref->getOutputs()[0]));
+    }
+
+    TEST(Rewrite, SinksTransposesThroughElementwise)
+    {
+        // Relu(T(a) + T(b)) * 2 -> T(Relu(a + b) * 2), then into the matmul,
+        // and the elementwise ops fuse
+        checkOptimizedMatches(
+            [](const Graph &g)
+            {
+                auto a = g->addTensor({2, 3, 4}), b = g->addTensor({2, 3, 4});
+                auto ta = g->addOp<TransposeObj>(a, nullptr, Shape{0, 2, 1})
+                              ->getOutput();
+                auto tb = g->addOp<TransposeObj>(b, nullptr, Shape{0, 2, 1})
+                              ->getOutput();
+                auto sum = g->addOp<AddObj>(ta, tb, nullptr)->getOutput();
+                auto relu = g->addOp<ReluObj>(sum, nullptr)->getOutput();
+                auto scaled =
+                    g->addOp<MulObj>(relu, g->addTensor(Shape{1}), nullptr)
+                        ->getOutput();
+                g->addOp<MatmulObj>(scaled, g->addTensor({2, 3, 5}), nullptr);
+            },
+            2);
+    }
+
+    TEST(Rewrite, SinksTransposesThroughConcat)
+    {
+        // Concat(T(a), T(b), axis 2) -> T(Concat(a, b, axis 0)), and the
+        // inverse transpose after it cancels
+        checkOptimizedMatches(
+            [](const Graph &g)
+            {
+                auto a = g->addTensor({2, 3, 4}), b = g->addTensor({5, 3, 4});
+                auto ta = g->addOp<TransposeObj>(a, nullptr, Shape{1, 2, 0})
+                              ->getOutput();
+                auto tb = g->addOp<TransposeObj>(b, nullptr, Shape{1, 2, 0})
+                              ->getOutput();
+                auto c = g->addOp<ConcatObj>(TensorVec{ta, tb}, nullptr, 2)
+                             ->getOutput();
+                auto back = g->addOp<TransposeObj>(c, nullptr, Shape{2, 0, 1})
+                                ->getOutput();
+                g->addOp<ReluObj>(back, nullptr);
+            },
+            2);
+    }
+
+    TEST(Rewrite, RunsToFixedPointWithStats)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor a = g->addTensor({4, 5}, DataType::Float32);
+        Tensor b = g->addTensor({5, 6}, DataType::Float32);
+        // four transposes cancelling in pairs, feeding a transposed matmul
+        Tensor t = a;
+        for (int i = 0; i < 5; ++i)
+            t = g->addOp<TransposeObj>(t, nullptr, Shape{1, 0})->getOutput();
+        auto matmul = g->addOp<MatmulObj>(t, b, nullptr, true);
+        auto o = matmul->getOutput();
+
+        PassManager passes(defaultRewriteRules());
+        EXPECT_EQ(passes.run(*g), 3);
+        ASSERT_EQ(g->getOperators().size(), 1);
+        EXPECT_EQ(matmul->getInputs(0), a);
+        EXPECT_EQ(matmul->getTransA(), false);
+        EXPECT_EQ(g->getTensors().size(), 3);
+        EXPECT_EQ(g->getOutputs(), TensorVec{o});
+        EXPECT_EQ(statsOf(passes, "compose-transposes").applied, 2);
+        EXPECT_EQ(statsOf(passes, "fold-transpose-into-matmul").applied, 1);
+        EXPECT_NE(passes.statsToString().find("fold-transpose-into-matmul"),
+                  string::npos);
+    }
+
+    TEST(Rewrite, FoldsConstantSubgraphs)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({2, 3}, DataType::Float32);
+        Tensor w = g->addTensor({4, 3}, DataType::Float32);
+        Tensor bias = g->addTensor({1, 4}, DataType::Float32);
+        w->setConstant();
+        w->setData(IncrementalGenerator());
+        bias->setConstant();
+        bias->setData(OneGenerator());
+        // (w^T + 1) is computed from constants only
+        auto wt = g->addOp<TransposeObj>(w, nullptr, Shape{1, 0})->getOutput();
+        auto shifted = g->addOp<AddObj>(wt, bias, nullptr)->getOutput();
+        auto y = g->addOp<MatmulObj>(x, shifted, nullptr)->getOutput();
+
+        g->optimize();
+        ASSERT_EQ(g->getOperators().size(), 1);
+        auto folded = g->getOperators()[0]->getInputs(1);
+        EXPECT_TRUE(folded->isConstant());
+        EXPECT_EQ(folded->getDims(), (Shape{3, 4}));
+        // w and bias had no other use and are dropped
+        EXPECT_EQ(g->getTensors().size(), 3);
+        EXPECT_TRUE(folded->equalData(vector<float>{1, 4, 7, 10, 2, 5, 8, 11,
+                                                    3, 6, 9, 12}));
+
+        g->dataMalloc();
+        x->setData(OneGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(y->equalData(vector<float>{6, 15, 24, 33, 6, 15, 24, 33}));
+    }
+
+    TEST(Rewrite, KeepsFoldedGraphOutputs)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor w = g->addTensor({2, 3}, DataType::Float32);
+        w->setConstant();
+        g->addOp<ReluObj>(w, nullptr);
+        g->optimize();
+        EXPECT_EQ(g->getOperators().size(), 1);
+    }
+
+    TEST(Rewrite, FusesMatmulEpilogue)
+    {
+        // Relu(x * w + bias + x2) becomes a single matmul
+        checkOptimizedMatches(
+            [](const Graph &g)
+            {
+                auto x = g->addTensor({6, 5}), w = g->addTensor({5, 7});
+                auto y = g->addOp<MatmulObj>(x, w, nullptr)->getOutput();
+                y = g->addOp<AddObj>(g->addTensor(Shape{7}), y, nullptr)
+                        ->getOutput();
+                y = g->addOp<AddObj>(y, g->addTensor({6, 7}), nullptr)
+                        ->getOutput();
+                g->addOp<ReluObj>(y, nullptr);
+            },
+            1);
+    }
+
+    TEST(Rewrite, KeepsMatmulOutputsWithOtherUses)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto y = g->addOp<MatmulObj>(g->addTensor({6, 5}),
+                                     g->addTensor({5, 7}), nullptr)
+                     ->getOutput();
+        g->addOp<ReluObj>(y, nullptr);
+        g->addOp<AddObj>(y, g->addTensor(Shape{7}), nullptr);
+        g->optimize();
+        EXPECT_EQ(g->getOperators().size(), 3);
+    }
+
+    TEST(Rewrite, FusesElementwiseChains)
+    {
+        // Clip(Relu(a * b + c) - d, 0, 6) with broadcast b, c and d
+        checkOptimizedMatches(
+            [](const Graph &g)
+            {
+                auto a = g->addTensor({4, 3, 20});
+                auto y = g->addOp<MulObj>(a, g->addTensor({3, 1}), nullptr)
+                             ->getOutput();
+                y = g->addOp<AddObj>(y, g->addTensor(Shape{20}), nullptr)
+                        ->getOutput();
+                y = g->addOp<ReluObj>(y, nullptr)->getOutput();
+                y = g->addOp<SubObj>(y, g->addTensor(Shape{1}), nullptr)
+                        ->getOutput();
+                g->addOp<ClipObj>(y, nullptr, 0.f, 6.f);
+            },
+            1);
+    }
+
+    TEST(Rewrite, FusionSplitsLongChains)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto y = g->addTensor({4, 5});
+        for (int i = 0; i < 100; ++i)
+            y = g->addOp<ReluObj>(y, nullptr)->getOutput();
+        g->optimize();
+        auto ops = g->getOperators();
+        ASSERT_EQ(ops.size(), 4);
+        size_t steps = 0;
+        for (auto &op : ops)
+        {
+            ASSERT_EQ(op->getOpType(), OpType::FusedElementwise);
+            auto size = as<FusedElementwiseObj>(op)->getProgram().size();
+            EXPECT_LE(size, MAX_FUSED_PROGRAM);
+            steps += size;
+        }
+        EXPECT_EQ(steps, 100);
+    }
+
+    TEST(Rewrite, FusionStopsAtSharedTensors)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor({4, 5}), b = g->addTensor({4, 5});
+        auto sum = g->addOp<AddObj>(a, b, nullptr)->getOutput();
+        // sum is read twice, but only by the Mul, which absorbs the Add
+        auto square = g->addOp<MulObj>(sum, sum, nullptr)->getOutput();
+        // square also feeds the matmul, so the Relu cannot absorb the Mul
+        auto relu = g->addOp<ReluObj>(square, nullptr);
+        g->addOp<MatmulObj>(square, g->addTensor({5, 2}), nullptr);
+        g->optimize();
+        ASSERT_EQ(g->getOperators().size(), 3);
+        auto fused = square->getSource();
+        ASSERT_EQ(fused->getOpType(), OpType::FusedElementwise);
+        EXPECT_EQ(fused->getInputs(), (TensorVec{a, b}));
+        EXPECT_EQ(as<FusedElementwiseObj>(fused)->getProgram().size(), 2);
+        EXPECT_EQ(relu->getInputs(0), square);
+    }
+} // namespace infini
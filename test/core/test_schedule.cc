@@ -0,0 +1,65 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/concat.h"
+#include "operators/matmul.h"
+#include "operators/unary.h"
+
+#include "test.h"
+
+namespace infini
+{
+    // `branches` branches Relu(x) -> MatMul(., w) -> small, concatenated,
+    // added breadth-first: every large Relu output is live at once.
+    static Graph buildWideGraph(int branches)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto x = g->addTensor({64, 64}), w = g->addTensor({64, 1});
+        TensorVec large, small;
+        for (int i = 0; i < branches; ++i)
+            large.push_back(g->addOp<ReluObj>(x, nullptr)->getOutput());
+        for (int i = 0; i < branches; ++i)
+            small.push_back(
+                g->addOp<MatmulObj>(large[i], w, nullptr)->getOutput());
+        g->addOp<ConcatObj>(small, nullptr, 1);
+        return g;
+    }
+
+    static void checkSchedule(int branches, size_t exactLimit)
+    {
+        auto g = buildWideGraph(branches);
+        size_t inputs = (64 * 64 + 64) * 4, relu = 64 * 64 * 4, col = 64 * 4;
+        auto report = g->schedule(exactLimit);
+        // as built, the first MatMul runs with every Relu output live
+        EXPECT_EQ(report.peakBefore, inputs + branches * relu + col);
+        // depth first, one Relu output at a time, peaking at the last MatMul
+        EXPECT_EQ(report.peakAfter, inputs + relu + branches * col);
+        EXPECT_EQ(peakLiveBytes(g->getOperators()), report.peakAfter);
+        EXPECT_TRUE(g->checkValid());
+
+        auto runtime = g->getRuntime();
+        auto ref = buildWideGraph(branches);
+        for (auto graph : {ref, g})
+        {
+            graph->dataMalloc();
+            for (auto &input : graph->getInputs())
+                input->setData(IncrementalGenerator());
+            runtime->run(graph);
+        }
+        EXPECT_TRUE(g->getOutputs()[0]->equalData(ref->getOutputs()[0]));
+    }
+
+    TEST(Schedule, ExactSearchOnSmallGraphs) { checkSchedule(4, 16); }
+
+    TEST(Schedule, GreedyOnLargeGraphs) { checkSchedule(40, 16); }
+
+    TEST(Schedule, KeepsAnOptimalOrder)
+    {
+        auto g = buildWideGraph(3);
+        g->schedule();
+        auto order = g->getOperators();
+        auto report = g->schedule(0);
+        EXPECT_EQ(report.peakAfter, report.peakBefore);
+        EXPECT_EQ(g->getOperators(), order);
+    }
+} // namespace infini
@@ -0,0 +1,91 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "core/thread_pool.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#include <numeric>
+
+namespace infini
+{
+    TEST(ThreadPool, CoversRangeOnce)
+    {
+        ThreadPool pool(4);
+        EXPECT_EQ(pool.getNumThreads(), 4);
+        vector<std::atomic<int>> hits(10007);
+        pool.parallel_for(3, hits.size(), 100, [&](size_t begin, size_t end)
+                          {
+            EXPECT_GE(end - begin, 100u);
+            for (size_t i = begin; i < end; ++i)
+                ++hits[i]; });
+        for (size_t i = 0; i < hits.size(); ++i)
+            ASSERT_EQ(hits[i].load(), i < 3 ? 0 : 1);
+    }
+
+    TEST(ThreadPool, SmallRangesRunInline)
+    {
+        ThreadPool pool(4);
+        auto caller = std::this_thread::get_id();
+        int calls = 0;
+        pool.parallel_for(0, 50, 64, [&](size_t begin, size_t end)
+                          {
+            EXPECT_EQ(std::this_thread::get_id(), caller);
+            EXPECT_EQ(begin, 0u);
+            EXPECT_EQ(end, 50u);
+            ++calls; });
+        EXPECT_EQ(calls, 1);
+    }
+
+    TEST(ThreadPool, NestedAndConcurrentLoops)
+    {
+        ThreadPool pool(4);
+        std::atomic<size_t> sum{0};
+        auto outer = [&]
+        {
+            pool.parallel_for(0, 16, 1, [&](size_t begin, size_t end)
+                              {
+                for (size_t i = begin; i < end; ++i)
+                    pool.parallel_for(0, 1000, 10, [&](size_t b, size_t e)
+                                      { sum += e - b; }); });
+        };
+        std::thread other(outer);
+        outer();
+        other.join();
+        EXPECT_EQ(sum.load(), 2u * 16 * 1000);
+    }
+
+    TEST(ThreadPool, RethrowsBodyErrors)
+    {
+        ThreadPool pool(4);
+        EXPECT_THROW(pool.parallel_for(0, 100, 1, [](size_t begin, size_t)
+                                       { IT_ASSERT(begin != 42); }),
+                     Exception);
+        // the pool keeps working after a failed loop
+        std::atomic<size_t> count{0};
+        pool.parallel_for(0, 100, 1, [&](size_t begin, size_t end)
+                          { count += end - begin; });
+        EXPECT_EQ(count.load(), 100u);
+    }
+
+    TEST(ThreadPool, RuntimeThreadCount)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        runtime->setNumThreads(3, {0});
+        EXPECT_EQ(runtime->getNumThreads(), 3);
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({1 << 18}, DataType::Float32);
+        auto o = g->addOp<ReluObj>(i, nullptr)->getOutput();
+        g->dataMalloc();
+        i->setData(IncrementalGenerator());
+        runtime->run(g);
+        vector<float> ans(i->size());
+        std::iota(ans.begin(), ans.end(), 0.f);
+        EXPECT_TRUE(o->equalData(ans));
+        // compiled routines pick up the new pool
+        runtime->setNumThreads(1);
+        EXPECT_EQ(runtime->getNumThreads(), 1);
+        o->setData(ZeroGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(o->equalData(ans));
+    }
+}
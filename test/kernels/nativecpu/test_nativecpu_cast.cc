@@ -0,0 +1,122 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/unary.h"
+#include "utils/half.h"
+
+#include "test.h"
+
+namespace infini {
+
+// Runs a Cast over `input` (of type `dataType`) and returns a copy of the
+// output, which would not outlive the graph.
+template <typename U, typename T>
+static vector<U> runCast(const vector<T> &input, DataType dataType,
+                         CastType type) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto i = g->addTensor({(int)input.size()}, dataType);
+    auto op = g->addOp<CastObj>(i, nullptr, type);
+    g->dataMalloc();
+    i->setData([&](void *data, size_t size, DataType) {
+        std::memcpy(data, input.data(), size * sizeof(T));
+    });
+    runtime->run(g);
+    auto out = op->getOutput()->getRawDataPtr<U *>();
+    return vector<U>(out, out + input.size());
+}
+
+TEST(Cast, Float16) {
+    // exact, ties to even, overflow, subnormal, zero and Inf, then enough
+    // elements for the vector loops to have a tail
+    vector<float> input{1.f, -2.5f, 65504.f, 65520.f, 1e6f, 1.f + 1.f / 2048,
+                        5.96046448e-8f, -0.f, INFINITY, 0.1f};
+    vector<uint16_t> ans{0x3C00, 0xC100, 0x7BFF, 0x7C00, 0x7C00,
+                         0x3C00, 0x0001, 0x8000, 0x7C00, 0x2E66};
+    for (int i = 0; i < 27; ++i) {
+        input.emplace_back(float(i - 13) * 0.25f);
+        ans.emplace_back(float_to_half(input.back()));
+    }
+    EXPECT_EQ(runCast<uint16_t>(input, DataType::Float32,
+                                CastType::Float2Float16),
+              ans);
+
+    vector<float> ansBack;
+    for (auto h : ans)
+        ansBack.emplace_back(half_to_float(h));
+    EXPECT_EQ(ansBack[2], 65504.f);
+    EXPECT_EQ(ansBack[6], 5.96046448e-8f);
+    EXPECT_EQ(runCast<float>(ans, DataType::Float16, CastType::Float162Float),
+              ansBack);
+}
+
+TEST(Cast, BFloat16) {
+    // 1 + 2^-8 is a tie rounding down to even, 1 + 3 * 2^-8 rounds up
+    vector<float> input{1.f, 1.00390625f, 1.01171875f, -3.f, INFINITY};
+    vector<uint16_t> ans{0x3F80, 0x3F80, 0x3F82, 0xC040, 0x7F80};
+    for (int i = 0; i < 36; ++i) {
+        input.emplace_back(float(i) * 1.1f - 20.f);
+        ans.emplace_back(float_to_bfloat16(input.back()));
+    }
+    input.emplace_back(NAN);
+    auto bf16 = runCast<uint16_t>(input, DataType::Float32,
+                                  CastType::Float2BFloat16);
+    EXPECT_EQ(bf16.back() & 0x7FC0, 0x7FC0);
+    ans.emplace_back(bf16.back());
+    EXPECT_EQ(bf16, ans);
+
+    auto back =
+        runCast<float>(ans, DataType::BFloat16, CastType::BFloat162Float);
+    for (size_t i = 0; i + 1 < ans.size(); ++i)
+        EXPECT_EQ(back[i], bfloat16_to_float(ans[i]));
+    EXPECT_TRUE(std::isnan(back.back()));
+}
+
+TEST(Cast, Saturating) {
+    vector<int32_t> input;
+    for (int i = 0; i < 45; ++i)
+        input.emplace_back((i - 22) * 1499);
+    vector<int8_t> ans8;
+    vector<int16_t> ans16;
+    for (auto x : input) {
+        ans8.emplace_back(std::clamp(x, -128, 127));
+        ans16.emplace_back(std::clamp(x, -32768, 32767));
+    }
+    EXPECT_EQ(runCast<int8_t>(input, DataType::Int32, CastType::Int322Int8),
+              ans8);
+    EXPECT_EQ(runCast<int16_t>(input, DataType::Int32, CastType::Int322Int16),
+              ans16);
+
+    vector<int64_t> input64{-1, 5000000000, 7, -5000000000, INT32_MAX,
+                            INT32_MIN, 0, 42, 1LL << 40};
+    EXPECT_EQ(runCast<int32_t>(input64, DataType::Int64,
+                               CastType::Int642Int32),
+              (vector<int32_t>{-1, INT32_MAX, 7, INT32_MIN, INT32_MAX,
+                               INT32_MIN, 0, 42, INT32_MAX}));
+    EXPECT_EQ(runCast<uint32_t>(input64, DataType::Int64,
+                                CastType::Int642Uint32),
+              (vector<uint32_t>{0, UINT32_MAX, 7, 0, INT32_MAX, 0, 0, 42,
+                                UINT32_MAX}));
+
+    vector<float> inputF{1.9f, -1.9f, 3e9f, -3e9f, NAN, 200.f, -200.5f,
+                         0.f,  1e5f,  2147483520.f};
+    EXPECT_EQ(runCast<int32_t>(inputF, DataType::Float32,
+                               CastType::Float2Int32),
+              (vector<int32_t>{1, -1, INT32_MAX, INT32_MIN, 0, 200, -200, 0,
+                               100000, 2147483520}));
+    EXPECT_EQ(runCast<int8_t>(inputF, DataType::Float32, CastType::Float2Int8),
+              (vector<int8_t>{1, -1, 127, -128, 0, 127, -128, 0, 127, 127}));
+}
+
+TEST(Cast, Widening) {
+    vector<int8_t> input{-128, -1, 0, 1, 127};
+    EXPECT_EQ(runCast<int32_t>(input, DataType::Int8, CastType::Int82Int32),
+              (vector<int32_t>{-128, -1, 0, 1, 127}));
+    EXPECT_EQ(runCast<float>(input, DataType::Int8, CastType::Int82Float),
+              (vector<float>{-128, -1, 0, 1, 127}));
+    vector<uint32_t> inputU{0, 1, UINT32_MAX};
+    EXPECT_EQ(runCast<int64_t>(inputU, DataType::UInt32,
+                               CastType::Uint322Int64),
+              (vector<int64_t>{0, 1, UINT32_MAX}));
+}
+
+} // namespace infini
@@ -1,6 +1,7 @@
 #include "core/graph.h"
 #include "core/runtime.h"
 #include "operators/concat.h"
+#include "utils/half.h"
 
 #include "test.h"
 
@@ -25,4 +26,58 @@ TEST(Concat, NativeCpu) {
                       6, 7, 8, 1, 1, 1, 9, 10, 11, 1, 1, 1}));
 }
 
+static void testConcatAxis(const vector<Shape> &shapes, int axis,
+                           DataType dataType = DataType::Float32) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    TensorVec inputs;
+    for (auto &shape : shapes)
+        inputs.emplace_back(g->addTensor(shape, dataType));
+    auto op = g->addOp<ConcatObj>(inputs, nullptr, axis);
+    g->dataMalloc();
+    for (auto &input : inputs)
+        input->setData(IncrementalGenerator());
+    runtime->run(g);
+
+    // every input holds its own flat index, so each run restarts per input
+    auto outDim = op->getOutput()->getDims();
+    size_t inner = 1, outer = 1;
+    for (size_t d = axis + 1; d < outDim.size(); ++d)
+        inner *= outDim[d];
+    for (int d = 0; d < axis; ++d)
+        outer *= outDim[d];
+    vector<float> ans;
+    for (size_t o = 0; o < outer; ++o)
+        for (auto &shape : shapes) {
+            size_t block = shape[axis] * inner;
+            for (size_t j = 0; j < block; ++j)
+                ans.emplace_back(float(o * block + j));
+        }
+    if (dataType == DataType::Float32) {
+        EXPECT_TRUE(op->getOutput()->equalData(ans));
+        return;
+    }
+    vector<uint16_t> bits;
+    for (float val : ans)
+        bits.emplace_back(dataType == DataType::Float16
+                              ? float_to_half(val)
+                              : float_to_bfloat16(val));
+    EXPECT_TRUE(op->getOutput()->equalData(bits));
+}
+
+TEST(Concat, NativeCpuAxes) {
+    testConcatAxis({{2, 3, 4}, {5, 3, 4}}, 0);
+    testConcatAxis({{2, 3, 4}, {2, 1, 4}, {2, 2, 4}}, 1);
+    testConcatAxis({{2, 3, 4}, {2, 3, 7}}, 2);
+    // large enough for chunked copies and non-temporal stores
+    testConcatAxis({{2, 300, 1000}, {2, 700, 1000}}, 1);
+}
+
+TEST(Concat, NativeCpuHalf) {
+    for (auto dataType : {DataType::Float16, DataType::BFloat16}) {
+        testConcatAxis({{2, 3, 4}, {2, 1, 4}, {2, 2, 4}}, 1, dataType);
+        testConcatAxis({{2, 3, 4}, {2, 3, 7}}, 2, dataType);
+    }
+}
+
 } // namespace infini
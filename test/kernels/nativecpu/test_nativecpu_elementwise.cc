@@ -1,6 +1,7 @@
 #include "core/graph.h"
 #include "core/runtime.h"
 #include "operators/element_wise.h"
+#include "utils/half.h"
 
 #include "test.h"
 
@@ -41,4 +42,83 @@ TEST(ElementWise, NativeCpu) {
         Shape{2, 1, 1}, ExpectOutput{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11});
 }
 
+// Rounds x to the precision of a 16-bit float `dataType`.
+static float roundTo(DataType dataType, float x) {
+    if (dataType == DataType::Float16)
+        return half_to_float(float_to_half(x));
+    if (dataType == DataType::BFloat16)
+        return bfloat16_to_float(float_to_bfloat16(x));
+    return x;
+}
+
+// Checks Add against a per-element broadcast reference, one shape pair per
+// fast path of the kernel. 16-bit float inputs are rounded by the generator
+// and the sum once more by the kernel.
+static void testBroadcastAdd(const Shape &shape1, const Shape &shape2,
+                             DataType dataType = DataType::Float32) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto t1 = g->addTensor(shape1, dataType);
+    auto t2 = g->addTensor(shape2, dataType);
+    auto op = g->addOp<AddObj>(t1, t2, nullptr);
+    g->dataMalloc();
+    t1->setData(IncrementalGenerator());
+    t2->setData(IncrementalGenerator());
+    runtime->run(g);
+
+    auto out = op->getOutput();
+    auto shapeC = out->getDims();
+    size_t rank = shapeC.size();
+    Shape a(rank - shape1.size(), 1), b(rank - shape2.size(), 1);
+    a.insert(a.end(), shape1.begin(), shape1.end());
+    b.insert(b.end(), shape2.begin(), shape2.end());
+    ExpectOutput ans(out->size());
+    for (size_t i = 0; i < ans.size(); ++i) {
+        size_t rest = i, ia = 0, ib = 0, sa = 1, sb = 1;
+        for (size_t d = rank; d-- > 0;) {
+            size_t idx = rest % shapeC[d];
+            rest /= shapeC[d];
+            ia += idx % a[d] * sa;
+            ib += idx % b[d] * sb;
+            sa *= a[d];
+            sb *= b[d];
+        }
+        ans[i] = roundTo(dataType, roundTo(dataType, float(ia)) +
+                                       roundTo(dataType, float(ib)));
+    }
+    if (dataType == DataType::Float32) {
+        EXPECT_TRUE(out->equalData(ans));
+        return;
+    }
+    auto ptr = out->getRawDataPtr<uint16_t *>();
+    ExpectOutput result(out->size());
+    for (size_t i = 0; i < result.size(); ++i)
+        result[i] = dataType == DataType::Float16 ? half_to_float(ptr[i])
+                                                  : bfloat16_to_float(ptr[i]);
+    EXPECT_EQ(result, ans);
+}
+
+TEST(ElementWise, NativeCpuBroadcast) {
+    testBroadcastAdd(Shape{3, 50, 700}, Shape{3, 50, 700}); // same shape
+    testBroadcastAdd(Shape{3, 50, 700}, Shape{1});          // scalar
+    testBroadcastAdd(Shape{1, 1}, Shape{4, 5, 6});          // scalar
+    testBroadcastAdd(Shape{2, 30, 7}, Shape{7});            // row
+    testBroadcastAdd(Shape{1, 7}, Shape{2, 30, 7});         // row
+    testBroadcastAdd(Shape{2, 30, 7}, Shape{2, 30, 1});     // column
+    testBroadcastAdd(Shape{60, 1}, Shape{60, 7});           // column
+    testBroadcastAdd(Shape{2, 1, 5, 7}, Shape{3, 1, 7});    // general
+    testBroadcastAdd(Shape{40, 1}, Shape{1, 30});           // outer product
+    testBroadcastAdd(Shape{200, 3, 1, 2}, Shape{3, 90, 1}); // general, large
+}
+
+TEST(ElementWise, NativeCpuHalf) {
+    for (auto dataType : {DataType::Float16, DataType::BFloat16}) {
+        testBroadcastAdd(Shape{3, 50, 700}, Shape{3, 50, 700}, dataType);
+        testBroadcastAdd(Shape{1}, Shape{3, 50, 70}, dataType);
+        testBroadcastAdd(Shape{2, 30, 7}, Shape{7}, dataType);
+        testBroadcastAdd(Shape{60, 1}, Shape{60, 7}, dataType);
+        testBroadcastAdd(Shape{2, 1, 5, 7}, Shape{3, 1, 7}, dataType);
+    }
+}
+
 } // namespace infini
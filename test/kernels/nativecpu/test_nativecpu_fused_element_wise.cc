@@ -0,0 +1,163 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/fused_element_wise.h"
+#include "operators/transpose.h"
+#include "utils/half.h"
+
+#include "test.h"
+
+namespace infini {
+
+// Reads element `i` of a Float32, Float16 or BFloat16 tensor as a float.
+static float loadFloat(const Tensor &t, size_t i) {
+    if (t->getDType() == DataType::Float32)
+        return t->getRawDataPtr<float *>()[i];
+    auto v = t->getRawDataPtr<uint16_t *>()[i];
+    return t->getDType() == DataType::Float16 ? half_to_float(v)
+                                              : bfloat16_to_float(v);
+}
+
+// Runs a FusedElementwise over `shapes` filled with IncrementalGenerator and
+// checks it against the program evaluated element by element in Float32,
+// with the result rounded once to `dataType`.
+static void testFusedElementwise(const vector<Shape> &shapes,
+                                 const vector<ElementwiseInstr> &program,
+                                 DataType dataType = DataType::Float32) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    TensorVec inputs;
+    for (auto &shape : shapes)
+        inputs.push_back(g->addTensor(shape, dataType));
+    auto op = g->addOp<FusedElementwiseObj>(inputs, nullptr, program);
+    g->dataMalloc();
+    for (auto &input : inputs)
+        input->setData(IncrementalGenerator());
+    runtime->run(g);
+
+    auto out = op->getOutput();
+    auto shapeC = out->getDims();
+    size_t rank = shapeC.size();
+    for (size_t i = 0; i < out->size(); ++i) {
+        vector<float> regs;
+        for (auto &input : inputs) {
+            auto dims = input->getDims();
+            dims.insert(dims.begin(), rank - dims.size(), 1);
+            size_t rest = i, offset = 0, stride = 1;
+            for (size_t d = rank; d-- > 0;) {
+                offset += rest % shapeC[d] % dims[d] * stride;
+                rest /= shapeC[d];
+                stride *= dims[d];
+            }
+            regs.push_back(loadFloat(input, offset));
+        }
+        for (auto &instr : program) {
+            float a = regs[instr.lhs], b = instr.rhs >= 0 ? regs[instr.rhs] : 0;
+            switch (instr.type.underlying()) {
+            case OpType::Add:
+                regs.push_back(a + b);
+                break;
+            case OpType::Sub:
+                regs.push_back(a - b);
+                break;
+            case OpType::Mul:
+                regs.push_back(a * b);
+                break;
+            case OpType::Div:
+                regs.push_back(a / b);
+                break;
+            case OpType::Relu:
+                regs.push_back(std::max(0.f, a));
+                break;
+            default:
+                regs.push_back(std::min(std::max(a, instr.min), instr.max));
+            }
+        }
+        float ans = regs.back();
+        if (dataType == DataType::Float16)
+            ans = half_to_float(float_to_half(ans));
+        else if (dataType == DataType::BFloat16)
+            ans = bfloat16_to_float(float_to_bfloat16(ans));
+        ASSERT_EQ(loadFloat(out, i), ans) << "at element " << i;
+    }
+}
+
+TEST(FusedElementwise, NativeCpu) {
+    // r4 = Relu(Clip(r0 * r1 - r2, -50, 3000)), r3 + r4: rows longer than
+    // a block, with a per-row scalar, a row vector and a plain scalar
+    vector<ElementwiseInstr> chain{{OpType::Mul, 0, 1},
+                                   {OpType::Sub, 4, 2},
+                                   {OpType::Clip, 5, -1, -50, 3000},
+                                   {OpType::Relu, 6},
+                                   {OpType::Add, 3, 7}};
+    testFusedElementwise({{2, 3, 600}, {3, 1}, {600}, {1}}, chain);
+    testFusedElementwise({{7, 1, 5}, {2, 1}, {1, 5}, {1}}, chain);
+    // every operand is a scalar
+    testFusedElementwise({{1}, {1, 1}},
+                         {{OpType::Sub, 0, 1}, {OpType::Relu, 2}});
+    // a tree reading an input twice: (r0 + r1) / max(r0, 1)
+    testFusedElementwise({{4, 70}, {70}},
+                         {{OpType::Add, 0, 1},
+                          {OpType::Clip, 0, -1, 1, INFINITY},
+                          {OpType::Div, 2, 3}});
+}
+
+TEST(FusedElementwise, NativeCpuLongPrograms) {
+    // r2 = r0 * r1 stays live while a hundred steps pass their blocks on,
+    // then is added to the last of them, and the sum is squared
+    vector<ElementwiseInstr> program{{OpType::Mul, 0, 1}};
+    for (int i = 0; i < 50; ++i) {
+        int last = 1 + program.size();
+        program.push_back({OpType::Sub, last, 1});
+        program.push_back({OpType::Clip, last + 1, -1, -100, 100});
+    }
+    program.push_back({OpType::Add, 2, int(1 + program.size())});
+    // a register read as both operands
+    program.push_back({OpType::Mul, int(1 + program.size()),
+                       int(1 + program.size())});
+    for (auto dataType : {DataType::Float32, DataType::Float16})
+        testFusedElementwise({{3, 600}, {600}}, program, dataType);
+}
+
+TEST(FusedElementwise, NativeCpuHalf) {
+    for (auto dataType : {DataType::Float16, DataType::BFloat16})
+        testFusedElementwise({{2, 3, 600}, {3, 1}, {600}},
+                             {{OpType::Mul, 0, 1},
+                              {OpType::Sub, 3, 2},
+                              {OpType::Clip, 4, -1, -50, 3000}},
+                             dataType);
+}
+
+TEST(FusedElementwise, NativeCpuStridedInputs) {
+    for (auto dataType :
+         {DataType::Float32, DataType::Float16, DataType::BFloat16}) {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({600, 3}, dataType);
+        Tensor y = g->addTensor({3, 600}, dataType);
+        // the transpose becomes a view: rows of x read 3 elements apart
+        auto t = g->addOp<TransposeObj>(x, nullptr, vector<int>{1, 0})
+                     ->getOutput();
+        auto op = g->addOp<FusedElementwiseObj>(
+            TensorVec{t, y}, nullptr,
+            vector<ElementwiseInstr>{{OpType::Add, 0, 1}});
+        g->dataMalloc();
+        ASSERT_FALSE(t->isContiguous());
+        x->setData(IncrementalGenerator());
+        y->setData(IncrementalGenerator());
+        runtime->run(g);
+        auto out = op->getOutput();
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 600; ++c) {
+                float ans =
+                    loadFloat(x, c * 3 + r) + loadFloat(y, r * 600 + c);
+                if (dataType == DataType::Float16)
+                    ans = half_to_float(float_to_half(ans));
+                else if (dataType == DataType::BFloat16)
+                    ans = bfloat16_to_float(float_to_bfloat16(ans));
+                ASSERT_EQ(loadFloat(out, r * 600 + c), ans)
+                    << "at " << r << ", " << c;
+            }
+    }
+}
+
+} // namespace infini
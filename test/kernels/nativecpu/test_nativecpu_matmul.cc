@@ -0,0 +1,214 @@
+#include "core/graph.h"
+#include "core/kernel.h"
+#include "core/runtime.h"
+#include "operators/matmul.h"
+#include "utils/half.h"
+
+#include "test.h"
+
+namespace infini {
+
+// Small integers keep every partial sum exact, so the blocked kernel must
+// match the reference bit for bit regardless of summation order. They are
+// exact in the 16-bit float types too, whose outputs are then rounded once.
+static void smallIntGenerator(void *data, size_t size, DataType dataType) {
+    for (size_t i = 0; i < size; ++i) {
+        float val = float(int(i * 7 % 11) - 5);
+        if (dataType == DataType::Float32)
+            reinterpret_cast<float *>(data)[i] = val;
+        else if (dataType == DataType::Float16)
+            reinterpret_cast<uint16_t *>(data)[i] = float_to_half(val);
+        else if (dataType == DataType::BFloat16)
+            reinterpret_cast<uint16_t *>(data)[i] = float_to_bfloat16(val);
+        else
+            IT_TODO_HALT();
+    }
+}
+
+static vector<float> floatData(const Tensor &tensor) {
+    vector<float> result(tensor->size());
+    auto dataType = tensor->getDType();
+    if (dataType == DataType::Float32) {
+        auto ptr = tensor->getRawDataPtr<float *>();
+        std::copy(ptr, ptr + result.size(), result.begin());
+        return result;
+    }
+    auto ptr = tensor->getRawDataPtr<uint16_t *>();
+    for (size_t i = 0; i < result.size(); ++i)
+        result[i] = dataType == DataType::Float16 ? half_to_float(ptr[i])
+                                                  : bfloat16_to_float(ptr[i]);
+    return result;
+}
+
+static vector<float> referenceMatmul(const Tensor &A, const Tensor &B,
+                                     const Shape &shapeC, bool transA,
+                                     bool transB) {
+    auto shapeA = A->getDims(), shapeB = B->getDims();
+    int rank = shapeC.size();
+    int M = shapeC[rank - 2], N = shapeC[rank - 1];
+    int K = transA ? shapeA[rank - 2] : shapeA[rank - 1];
+    size_t batch = 1;
+    for (int d = 0; d < rank - 2; ++d)
+        batch *= shapeC[d];
+    auto dataA = floatData(A), dataB = floatData(B);
+    const float *a = dataA.data(), *b = dataB.data();
+    vector<float> ans(batch * M * N);
+    for (size_t bc = 0; bc < batch; ++bc) {
+        // map the output batch index back to A and B, honoring broadcast
+        size_t ba = 0, bb = 0, rest = bc, sa = 1, sb = 1;
+        for (int d = rank - 3; d >= 0; --d) {
+            size_t idx = rest % shapeC[d];
+            rest /= shapeC[d];
+            ba += (shapeA[d] == 1 ? 0 : idx) * sa;
+            bb += (shapeB[d] == 1 ? 0 : idx) * sb;
+            sa *= shapeA[d];
+            sb *= shapeB[d];
+        }
+        const float *pa = a + ba * M * K, *pb = b + bb * K * N;
+        for (int i = 0; i < M; ++i)
+            for (int j = 0; j < N; ++j) {
+                float sum = 0;
+                for (int k = 0; k < K; ++k)
+                    sum += (transA ? pa[k * M + i] : pa[i * K + k]) *
+                           (transB ? pb[j * K + k] : pb[k * N + j]);
+                ans[bc * M * N + i * N + j] = sum;
+            }
+    }
+    return ans;
+}
+
+static void testMatmulNativeCpu(const Shape &shapeA, const Shape &shapeB,
+                                bool transA, bool transB,
+                                DataType dataType = DataType::Float32) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto A = g->addTensor(shapeA, dataType);
+    auto B = g->addTensor(shapeB, dataType);
+    auto op = g->addOp<MatmulObj>(A, B, nullptr, transA, transB);
+    g->dataMalloc();
+    A->setData(smallIntGenerator);
+    B->setData(smallIntGenerator);
+    // the arena is not zeroed: stale data must not leak into C
+    op->getOutput()->setData(ValGenerator<123>());
+
+    runtime->run(g);
+    auto C = op->getOutput();
+    auto ans = referenceMatmul(A, B, C->getDims(), transA, transB);
+    if (dataType == DataType::Float32) {
+        EXPECT_TRUE(C->equalData(ans));
+        return;
+    }
+    vector<uint16_t> bits;
+    for (float val : ans)
+        bits.emplace_back(dataType == DataType::Float16
+                              ? float_to_half(val)
+                              : float_to_bfloat16(val));
+    EXPECT_TRUE(C->equalData(bits));
+}
+
+TEST(Matmul, NativeCpu) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto A = g->addTensor({1, 2, 3}, DataType::Float32);
+    auto B = g->addTensor({1, 3, 2}, DataType::Float32);
+    auto op = g->addOp<MatmulObj>(A, B, nullptr);
+    g->dataMalloc();
+    A->setData(IncrementalGenerator());
+    B->setData(IncrementalGenerator());
+
+    runtime->run(g);
+    EXPECT_TRUE(op->getOutput()->equalData(vector<float>{10, 13, 28, 40}));
+}
+
+TEST(Matmul, NativeCpuTranspose) {
+    testMatmulNativeCpu({1, 37, 53}, {1, 53, 41}, false, false);
+    testMatmulNativeCpu({1, 53, 37}, {1, 53, 41}, true, false);
+    testMatmulNativeCpu({1, 37, 53}, {1, 41, 53}, false, true);
+    testMatmulNativeCpu({1, 53, 37}, {1, 41, 53}, true, true);
+}
+
+TEST(Matmul, NativeCpuBlocked) {
+    // spans several MC/KC/NC blocks and leaves ragged edge tiles
+    testMatmulNativeCpu({1, 301, 517}, {1, 517, 263}, false, false);
+    testMatmulNativeCpu({1, 517, 301}, {1, 263, 517}, true, true);
+}
+
+TEST(Matmul, NativeCpuBroadcast) {
+    testMatmulNativeCpu({2, 3, 7, 5}, {1, 3, 5, 9}, false, false);
+    testMatmulNativeCpu({1, 3, 5, 7}, {2, 1, 9, 5}, true, true);
+}
+
+// C = max(A * B + bias + residual, 0), with the bias along N.
+static void testMatmulEpilogueNativeCpu(const Shape &shapeA,
+                                        const Shape &shapeB,
+                                        const Shape &shapeC,
+                                        DataType dataType) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto A = g->addTensor(shapeA, dataType);
+    auto B = g->addTensor(shapeB, dataType);
+    auto bias = g->addTensor({1, shapeC.back()}, dataType);
+    auto residual = g->addTensor(shapeC, dataType);
+    auto op = g->addOp<MatmulObj>(A, B, nullptr, false, false, bias, residual,
+                                  0.f, std::nullopt);
+    g->dataMalloc();
+    for (auto &input : {A, B, bias, residual})
+        input->setData(smallIntGenerator);
+    op->getOutput()->setData(ValGenerator<123>());
+
+    runtime->run(g);
+    auto C = op->getOutput();
+    auto ans = referenceMatmul(A, B, C->getDims(), false, false);
+    auto dataBias = floatData(bias), dataResidual = floatData(residual);
+    for (size_t i = 0; i < ans.size(); ++i)
+        ans[i] = std::max(ans[i] + dataBias[i % dataBias.size()] +
+                              dataResidual[i],
+                          0.f);
+    if (dataType == DataType::Float32) {
+        EXPECT_TRUE(C->equalData(ans));
+        return;
+    }
+    vector<uint16_t> bits;
+    for (float val : ans)
+        bits.emplace_back(dataType == DataType::Float16
+                              ? float_to_half(val)
+                              : float_to_bfloat16(val));
+    EXPECT_TRUE(C->equalData(bits));
+}
+
+TEST(Matmul, NativeCpuEpilogue) {
+    for (auto dataType :
+         {DataType::Float32, DataType::Float16, DataType::BFloat16}) {
+        testMatmulEpilogueNativeCpu({1, 37, 53}, {1, 53, 41}, {1, 37, 41},
+                                    dataType);
+        // ragged edge tiles and several K panels
+        testMatmulEpilogueNativeCpu({1, 301, 517}, {1, 517, 263},
+                                    {1, 301, 263}, dataType);
+        testMatmulEpilogueNativeCpu({2, 3, 7, 5}, {1, 3, 5, 9}, {2, 3, 7, 9},
+                                    dataType);
+    }
+}
+
+TEST(Matmul, NativeCpuEmptyK) {
+    for (auto dataType :
+         {DataType::Float32, DataType::Float16, DataType::BFloat16}) {
+        testMatmulNativeCpu({1, 4, 0}, {1, 0, 4}, false, false, dataType);
+        testMatmulNativeCpu({2, 0, 37}, {2, 41, 0}, true, true, dataType);
+        testMatmulEpilogueNativeCpu({1, 37, 0}, {1, 0, 41}, {1, 37, 41},
+                                    dataType);
+    }
+}
+
+TEST(Matmul, NativeCpuHalf) {
+    for (auto dataType : {DataType::Float16, DataType::BFloat16}) {
+        testMatmulNativeCpu({1, 37, 53}, {1, 53, 41}, false, false, dataType);
+        testMatmulNativeCpu({1, 53, 37}, {1, 41, 53}, true, true, dataType);
+        // K spans several KC blocks, accumulated in Float32 throughout
+        testMatmulNativeCpu({1, 301, 517}, {1, 517, 263}, false, false,
+                            dataType);
+        testMatmulNativeCpu({2, 3, 7, 5}, {1, 3, 9, 5}, false, true,
+                            dataType);
+    }
+}
+
+} // namespace infini
@@ -24,4 +24,61 @@ TEST(Transpose, NativeCpu) {
                                                           8, 9, 10, 11, 20, 21, 22, 23}));
 }
 
+static void testTransposePermute(const Shape &shape, const Shape &permute,
+                                 DataType dataType = DataType::Float32) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto input = g->addTensor(shape, dataType);
+    auto op = g->addOp<TransposeObj>(input, nullptr, permute);
+    g->dataMalloc();
+    input->setData(IncrementalGenerator());
+    runtime->run(g);
+
+    size_t rank = shape.size();
+    Shape inStride(rank), outDim = op->getOutput()->getDims();
+    for (size_t d = rank, p = 1; d-- > 0;) {
+        inStride[d] = p;
+        p *= shape[d];
+    }
+    vector<size_t> inIdx(input->size());
+    for (size_t i = 0; i < inIdx.size(); ++i) {
+        size_t rest = i;
+        for (size_t d = rank; d-- > 0;) {
+            inIdx[i] += rest % outDim[d] * inStride[permute[d]];
+            rest /= outDim[d];
+        }
+    }
+    if (dataType == DataType::Float32) {
+        vector<float> ans(inIdx.begin(), inIdx.end());
+        EXPECT_TRUE(op->getOutput()->equalData(ans));
+        return;
+    }
+    // 16-bit values are only moved, so compare their bits
+    auto in = input->getRawDataPtr<uint16_t *>();
+    vector<uint16_t> ans(inIdx.size());
+    for (size_t i = 0; i < ans.size(); ++i)
+        ans[i] = in[inIdx[i]];
+    EXPECT_TRUE(op->getOutput()->equalData(ans));
+}
+
+TEST(Transpose, NativeCpuPermutations) {
+    testTransposePermute({2, 70, 133}, {0, 2, 1});    // blocked 2-D
+    testTransposePermute({3, 4, 5, 6}, {1, 0, 3, 2}); // two swaps
+    testTransposePermute({4, 6, 8, 10}, {0, 3, 1, 2});
+    testTransposePermute({5, 6, 7}, {2, 0, 1});
+    testTransposePermute({5, 6, 7}, {1, 0, 2});
+    testTransposePermute({3, 4, 5, 6}, {3, 2, 1, 0});
+    testTransposePermute({1, 5, 1, 7}, {3, 2, 1, 0}); // unit dims
+    testTransposePermute({4, 5, 6}, {0, 1, 2});       // identity
+    testTransposePermute({0, 4}, {1, 0});             // empty
+}
+
+TEST(Transpose, NativeCpuHalf) {
+    for (auto dataType : {DataType::Float16, DataType::BFloat16}) {
+        testTransposePermute({2, 70, 133}, {0, 2, 1}, dataType);
+        testTransposePermute({4, 6, 8, 10}, {0, 3, 1, 2}, dataType);
+        testTransposePermute({3, 4, 5, 6}, {3, 2, 1, 0}, dataType);
+    }
+}
+
 } // namespace infini
@@ -0,0 +1,111 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/unary.h"
+#include "utils/half.h"
+
+#include "test.h"
+
+namespace infini {
+
+// Values from -size/2 upwards, so both signs and ragged vector tails occur.
+static void centeredGenerator(void *data, size_t size, DataType dataType) {
+    for (size_t i = 0; i < size; ++i) {
+        float val = float(i) - float(size / 2);
+        if (dataType == DataType::Float32)
+            reinterpret_cast<float *>(data)[i] = val;
+        else if (dataType == DataType::Float16)
+            reinterpret_cast<uint16_t *>(data)[i] = float_to_half(val);
+        else if (dataType == DataType::BFloat16)
+            reinterpret_cast<uint16_t *>(data)[i] = float_to_bfloat16(val);
+        else
+            IT_TODO_HALT();
+    }
+}
+
+// The data of a 16-bit float tensor, widened to float.
+static vector<float> halfData(const Tensor &tensor) {
+    auto ptr = tensor->getRawDataPtr<uint16_t *>();
+    vector<float> result(tensor->size());
+    for (size_t i = 0; i < result.size(); ++i)
+        result[i] = tensor->getDType() == DataType::Float16
+                        ? half_to_float(ptr[i])
+                        : bfloat16_to_float(ptr[i]);
+    return result;
+}
+
+TEST(Relu, NativeCpu) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto input = g->addTensor({3, 37}, DataType::Float32);
+    auto op = g->addOp<ReluObj>(input, nullptr);
+    g->dataMalloc();
+    input->setData(centeredGenerator);
+    runtime->run(g);
+
+    vector<float> ans(input->size());
+    for (size_t i = 0; i < ans.size(); ++i)
+        ans[i] = std::max(0.f, float(i) - float(ans.size() / 2));
+    EXPECT_TRUE(op->getOutput()->equalData(ans));
+}
+
+TEST(Clip, NativeCpu) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    for (auto [minValue, maxValue] :
+         vector<pair<optional<float>, optional<float>>>{
+             {-3.5f, 7.f}, {-3.5f, std::nullopt}, {std::nullopt, 7.f}}) {
+        Graph g = make_ref<GraphObj>(runtime);
+        auto input = g->addTensor({5, 19}, DataType::Float32);
+        auto op = g->addOp<ClipObj>(input, nullptr, minValue, maxValue);
+        g->dataMalloc();
+        input->setData(centeredGenerator);
+        runtime->run(g);
+
+        vector<float> ans(input->size());
+        for (size_t i = 0; i < ans.size(); ++i) {
+            float val = float(i) - float(ans.size() / 2);
+            if (minValue)
+                val = std::max(val, *minValue);
+            if (maxValue)
+                val = std::min(val, *maxValue);
+            ans[i] = val;
+        }
+        EXPECT_TRUE(op->getOutput()->equalData(ans));
+    }
+}
+
+TEST(Relu, NativeCpuHalf) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    for (auto dataType : {DataType::Float16, DataType::BFloat16}) {
+        Graph g = make_ref<GraphObj>(runtime);
+        auto input = g->addTensor({3, 401}, dataType);
+        auto op = g->addOp<ReluObj>(input, nullptr);
+        g->dataMalloc();
+        input->setData(centeredGenerator);
+        runtime->run(g);
+
+        // the inputs are already rounded, Relu and Clip are exact on them
+        auto ans = halfData(input);
+        for (auto &val : ans)
+            val = std::max(0.f, val);
+        EXPECT_EQ(halfData(op->getOutput()), ans);
+    }
+}
+
+TEST(Clip, NativeCpuHalf) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    for (auto dataType : {DataType::Float16, DataType::BFloat16}) {
+        Graph g = make_ref<GraphObj>(runtime);
+        auto input = g->addTensor({5, 219}, dataType);
+        auto op = g->addOp<ClipObj>(input, nullptr, -3.5f, 7.f);
+        g->dataMalloc();
+        input->setData(centeredGenerator);
+        runtime->run(g);
+
+        auto ans = halfData(input);
+        for (auto &val : ans)
+            val = std::clamp(val, -3.5f, 7.f);
+        EXPECT_EQ(halfData(op->getOutput()), ans);
+    }
+}
+
+} // namespace infini